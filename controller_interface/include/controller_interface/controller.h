@@ -52,7 +52,7 @@ template <class T>
 class Controller: public ControllerBase
 {
 public:
-  Controller()  {state_ = CONSTRUCTED;}
+  Controller()  {}
   virtual ~Controller<T>(){}
 
   /** \brief The init function is called to initialize the controller from a
@@ -92,7 +92,8 @@ protected:
   /** \brief Initialize the controller from a RobotHW pointer
    *
    * This calls \ref init with the hardware interface for this controller if it
-   * can extract the correct interface from \c robot_hw.
+   * can extract the correct interface from \c robot_hw. The real-time memory
+   * arena of the controller, if any, is set up before.
    *
    */
   virtual bool initRequest(hardware_interface::RobotHW* robot_hw,
@@ -100,7 +101,7 @@ protected:
                            std::set<std::string> &claimed_resources)
   {
     // check if construction finished cleanly
-    if (state_ != CONSTRUCTED){
+    if (getState() != CONSTRUCTED){
       ROS_ERROR("Cannot initialize this controller because it failed to be constructed");
       return false;
     }
@@ -115,6 +116,10 @@ protected:
       return false;
     }
 
+    // set up the real-time memory arena, so that it's available to init
+    if (!initArena(controller_nh))
+      return false;
+
     // return which resources are claimed by this controller
     hw->clearClaims();
     if (!init(hw, controller_nh) || !init(hw, root_nh, controller_nh))
@@ -126,7 +131,7 @@ protected:
     hw->clearClaims();
 
     // success
-    state_ = INITIALIZED;
+    setState(INITIALIZED);
     return true;
   }
 
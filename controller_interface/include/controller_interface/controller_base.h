@@ -33,8 +33,17 @@
 #ifndef CONTROLLER_INTERFACE_CONTROLLER_BASE_H
 #define CONTROLLER_INTERFACE_CONTROLLER_BASE_H
 
+#include <vector>
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 #include <ros/node_handle.h>
+#include <ros/console.h>
 #include <hardware_interface/robot_hw.h>
+#include <controller_interface/controller_worker.h>
+#include <controller_interface/exported_interface.h>
+#include <controller_interface/realtime_arena.h>
 
 
 namespace controller_interface
@@ -49,8 +58,16 @@ namespace controller_interface
 class ControllerBase
 {
 public:
-  ControllerBase(): state_(CONSTRUCTED){}
-  virtual ~ControllerBase(){}
+  /// The execution states of a controller
+  enum ControllerState {CONSTRUCTED, INITIALIZED, RUNNING};
+
+  ControllerBase(): state_(CONSTRUCTED), state_transitions_(0){}
+  virtual ~ControllerBase()
+  {
+    // Stop the worker while all of it is still alive
+    if (worker_)
+      worker_->shutdown();
+  }
 
   /** \name Real-Time Safe Functions
    *\{*/
@@ -76,18 +93,61 @@ public:
    */
   virtual void stopping(const ros::Time& time) {};
 
+  /** \brief This is called from within the realtime thread when this
+   * controller replaces a running one, right after the \ref stopping of its
+   * predecessor and before its own \ref starting
+   *
+   * Override it to carry state over from the predecessor (eg. integrator
+   * terms, or the trajectory being executed), so that the replacement is
+   * bumpless. The predecessor is usually of the same type, and can be
+   * downcast with \c dynamic_cast.
+   *
+   * \param predecessor The controller being replaced. It is stopped, and will
+   * be destroyed soon after.
+   */
+  virtual void takeOver(ControllerBase& predecessor) {};
+
   /** \brief Check if the controller is running
+   *
+   * Lock-free, can be called from any thread.
+   *
    * \returns true if the controller is running
    */
-  bool isRunning()
+  bool isRunning() const
+  {
+    return (getState() == RUNNING);
+  }
+
+  /** \brief Get the current execution state of the controller
+   *
+   * Lock-free, can be called from any thread. State changes made by the
+   * thread that started or stopped the controller are visible to the caller
+   * once the new state is.
+   */
+  ControllerState getState() const
+  {
+    return state_.load(boost::memory_order_acquire);
+  }
+
+  /** \brief Get the number of state transitions the controller went through
+   *
+   * The count increases every time the controller is initialized, started or
+   * stopped. Comparing two readings tells whether the controller changed state
+   * in between, even if it ended up in the same state (eg. when restarted).
+   * Lock-free, can be called from any thread. A transition is counted before
+   * its new state is published, so a count read after \ref getState includes
+   * the transition to the state that was returned.
+   */
+  boost::uint64_t getStateTransitionCount() const
   {
-    return (state_ == RUNNING);
+    return state_transitions_.load(boost::memory_order_acquire);
   }
 
   /// Calls \ref update only if this controller is running.
   void updateRequest(const ros::Time& time, const ros::Duration& period)
   {
-    if (state_ == RUNNING)
+    // Only the real-time thread starts and stops controllers, so it always sees its own latest state
+    if (state_.load(boost::memory_order_relaxed) == RUNNING)
       update(time, period);
   }
 
@@ -95,9 +155,12 @@ public:
   bool startRequest(const ros::Time& time)
   {
     // start succeeds even if the controller was already started
-    if (state_ == RUNNING || state_ == INITIALIZED){
+    const ControllerState state = state_.load(boost::memory_order_relaxed);
+    if (state == RUNNING || state == INITIALIZED){
+      if (worker_)
+        worker_->activate();
       starting(time);
-      state_ = RUNNING;
+      setState(RUNNING);
       return true;
     }
     else
@@ -108,9 +171,12 @@ public:
   bool stopRequest(const ros::Time& time)
   {
     // stop succeeds even if the controller was already stopped
-    if (state_ == RUNNING || state_ == INITIALIZED){
+    const ControllerState state = state_.load(boost::memory_order_relaxed);
+    if (state == RUNNING || state == INITIALIZED){
       stopping(time);
-      state_ = INITIALIZED;
+      if (worker_)
+        worker_->deactivate();
+      setState(INITIALIZED);
       return true;
     }
     else
@@ -122,6 +188,41 @@ public:
   /** \name Non Real-Time Safe Functions
    *\{*/
 
+  /** \brief This is called from a non-realtime thread before the controller
+   * is started
+   *
+   * Override it to do the work needed to start the controller that is not
+   * real-time safe (eg. allocating memory or reading parameters), so that
+   * \ref starting only has bounded, real-time safe work left. It is not called
+   * when a running controller is restarted, as it would run concurrently with
+   * \ref update.
+   *
+   * \returns True if the controller can be started
+   */
+  virtual bool prepareStart() {return true;}
+
+  /** \brief This is called from a non-realtime thread after the controller has
+   * been stopped
+   *
+   * Override it to do the cleanup after \ref stopping that is not real-time
+   * safe (eg. releasing memory). It is not called when the controller was
+   * restarted.
+   */
+  virtual void cleanupStop() {}
+
+  /// Calls \ref prepareStart only if this controller is initialized and not running
+  bool prepareStartRequest()
+  {
+    return (getState() == INITIALIZED) ? prepareStart() : true;
+  }
+
+  /// Calls \ref cleanupStop only if this controller is initialized and not running
+  void cleanupStopRequest()
+  {
+    if (getState() == INITIALIZED)
+      cleanupStop();
+  }
+
   /// Get the name of this controller's hardware interface type
   virtual std::string getHardwareInterfaceType() const = 0;
 
@@ -145,11 +246,132 @@ public:
 
   /*\}*/
 
-  /// The current execution state of the controller
-  enum {CONSTRUCTED, INITIALIZED, RUNNING} state_;
+  /** \brief Get the real-time memory arena of this controller
+   *
+   * The arena is set up before the controller is initialized, if the
+   * controller has a \c realtime_arena_size parameter (in bytes), and it is
+   * reclaimed wholesale when the controller is unloaded. Its blocks can be
+   * allocated and released from \ref update.
+   *
+   * \returns The arena, or NULL if the controller has none
+   */
+  RealtimeArena* getArena() const
+  {
+    return arena_.get();
+  }
+
+  /** \brief Get the non-realtime worker of this controller
+   *
+   * \returns The worker, or NULL if the controller has none
+   */
+  ControllerWorkerBase* getWorker() const
+  {
+    return worker_.get();
+  }
+
+  /** \brief Get the hardware interfaces this controller exports to other controllers
+   *
+   * \see exportInterface
+   */
+  const std::vector<boost::shared_ptr<ExportedInterfaceBase> >& getExportedInterfaces() const
+  {
+    return exported_interfaces_;
+  }
 
+protected:
+  /** \brief Set up the real-time memory arena of the controller
+   *
+   * Reads the arena size from the \c realtime_arena_size parameter in the
+   * namespace of the controller. Controllers without that parameter get no
+   * arena. Blocks are rounded up to powers of two, so the size must allow for
+   * that rounding (see \ref RealtimeArena). Not real-time safe.
+   *
+   * \param controller_nh A NodeHandle in the namespace of the controller.
+   *
+   * \returns False if the arena size is invalid
+   */
+  bool initArena(const ros::NodeHandle& controller_nh)
+  {
+    int arena_size = 0;
+    controller_nh.getParam("realtime_arena_size", arena_size);
+    if (arena_size < 0)
+    {
+      ROS_ERROR("Invalid real-time arena size %d for controller in namespace '%s'",
+                arena_size, controller_nh.getNamespace().c_str());
+      return false;
+    }
+    arena_.reset(arena_size > 0 ? new RealtimeArena(arena_size) : NULL);
+    return true;
+  }
+
+  /** \brief Attach a non-realtime worker to the controller
+   *
+   * The controller takes ownership of the worker, and starts its thread right
+   * away. The worker processes requests only while the controller is running:
+   * it is activated just before \ref starting, and deactivated just after
+   * \ref stopping. Typically called from \c init. Not real-time safe.
+   *
+   * \param worker The worker, which the controller should keep a typed
+   * pointer to in order to submit requests and receive results.
+   */
+  void setWorker(ControllerWorkerBase* worker)
+  {
+    if (worker_)
+      worker_->shutdown();
+    worker_.reset(worker);
+    if (worker_)
+      worker_->startThread();
+  }
+
+  /** \brief Export a hardware interface to other controllers
+   *
+   * The handles of \c iface become available to the controllers loaded after
+   * this one, which claim them as if they were provided by the robot hardware
+   * (eg. an outer-loop controller commanding this one). The controller manager
+   * updates the controllers that claim them before this one, so that a
+   * cascade of controllers runs within a single control cycle. Must be called
+   * from \c init. Not real-time safe.
+   *
+   * Exported resource names must not clash with those of the robot hardware or
+   * of other controllers, so prefixing them with the controller name is a
+   * good convention.
+   *
+   * \tparam T The hardware interface type, eg. \ref hardware_interface::VelocityJointInterface
+   * \param iface The interface to export. The controller owns it, and must keep it alive.
+   */
+  template <class T>
+  void exportInterface(T* iface)
+  {
+    exported_interfaces_.push_back(boost::shared_ptr<ExportedInterfaceBase>(new ExportedInterface<T>(iface)));
+  }
+
+  /** \brief Change the execution state of the controller
+   *
+   * The new state is published with release semantics, so that anything the
+   * controller did before the transition, including counting it, is visible
+   * to threads that observe the new state through \ref getState.
+   */
+  void setState(ControllerState state)
+  {
+    state_transitions_.fetch_add(1, boost::memory_order_relaxed);
+    state_.store(state, boost::memory_order_release);
+  }
+
+  /** \brief The execution state of the controller
+   *
+   * Kept reachable from derived classes for compatibility with code written
+   * against the former plain enum member. Assigning it directly bypasses the
+   * transition counter; use \ref setState to change the state and
+   * \ref getState to read it.
+   */
+  boost::atomic<ControllerState> state_;
 
 private:
+  boost::atomic<boost::uint64_t> state_transitions_;
+  boost::scoped_ptr<RealtimeArena> arena_;
+  boost::scoped_ptr<ControllerWorkerBase> worker_;
+  std::vector<boost::shared_ptr<ExportedInterfaceBase> > exported_interfaces_;
+
   ControllerBase(const ControllerBase &c);
   ControllerBase& operator =(const ControllerBase &c);
 
@@ -0,0 +1,298 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2012, hiDOF INC.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of hiDOF, Inc. nor the names of its
+//     contributors may be used to endorse or promote products derived from
+//     this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef CONTROLLER_INTERFACE_CONTROLLER_WORKER_H
+#define CONTROLLER_INTERFACE_CONTROLLER_WORKER_H
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <semaphore.h>
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/lockfree/spsc_queue.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/thread.hpp>
+#include <ros/time.h>
+
+
+namespace controller_interface
+{
+
+/** \brief Non-realtime worker thread of a controller
+ *
+ * This is the type-independent part of \ref ControllerWorker, through which
+ * \ref ControllerBase manages the worker: its thread is started when the
+ * worker is attached to a controller, it only processes requests while the
+ * controller is running, and it is shut down when the controller is
+ * destroyed.
+ *
+ * Every time the controller is started, the worker enters a new activation
+ * generation. Requests and results are stamped with the generation they
+ * belong to, and those of earlier generations are dropped, so that work
+ * submitted before the controller was stopped never reaches it after it is
+ * restarted.
+ */
+class ControllerWorkerBase : private boost::noncopyable
+{
+public:
+  ControllerWorkerBase()
+    : active_(false),
+      shutdown_(false),
+      generation_(0),
+      num_requests_(0),
+      max_compute_time_(0.0),
+      mean_compute_time_(0.0)
+  {
+    sem_init(&semaphore_, 0, 0);
+  }
+
+  virtual ~ControllerWorkerBase()
+  {
+    // The owning controller must join the thread while the derived worker is
+    // still alive, as the thread runs its process() and uses its mailboxes
+    assert(!thread_.joinable());
+    sem_destroy(&semaphore_);
+  }
+
+  /** \name Compute Time Statistics
+   * These can be read from any thread.
+   *\{*/
+
+  /// Number of requests processed so far
+  boost::uint64_t getNumRequests() const {return num_requests_.load(boost::memory_order_relaxed);}
+
+  /// Longest time taken to process a request, in seconds
+  double getMaxComputeTime() const {return max_compute_time_.load(boost::memory_order_relaxed);}
+
+  /// Mean time taken to process a request, over a sliding window of recent requests, in seconds
+  double getMeanComputeTime() const {return mean_compute_time_.load(boost::memory_order_relaxed);}
+
+  /*\}*/
+
+protected:
+  /// \returns True while the owning controller is running
+  bool isActive() const {return active_.load(boost::memory_order_acquire);}
+
+  /// \returns The current activation generation, bumped every time the owning controller is started
+  boost::uint32_t getGeneration() const {return generation_.load(boost::memory_order_acquire);}
+
+  /// Wake up the worker thread. Real-time safe.
+  void notify() {sem_post(&semaphore_);}
+
+  /** \brief Process pending requests
+   *
+   * Called from the worker thread every time it is woken up.
+   */
+  virtual void process() = 0;
+
+  /// Account for the processing of one request. Called from the worker thread.
+  void recordComputeTime(double compute_time)
+  {
+    static const double weight = 0.01; // Roughly the last hundred requests
+    const double mean = mean_compute_time_.load(boost::memory_order_relaxed);
+    mean_compute_time_.store(mean + weight * (compute_time - mean), boost::memory_order_relaxed);
+    max_compute_time_.store(std::max(max_compute_time_.load(boost::memory_order_relaxed), compute_time),
+                            boost::memory_order_relaxed);
+    num_requests_.fetch_add(1, boost::memory_order_relaxed);
+  }
+
+private:
+  friend class ControllerBase;
+
+  /// Start the worker thread. Not real-time safe.
+  void startThread()
+  {
+    if (!thread_.joinable())
+      thread_ = boost::thread(&ControllerWorkerBase::run, this);
+  }
+
+  /// Stop and join the worker thread. Not real-time safe.
+  void shutdown()
+  {
+    if (!thread_.joinable())
+      return;
+    shutdown_.store(true, boost::memory_order_release);
+    notify();
+    thread_.join();
+  }
+
+  /// Start processing requests of a new generation. Real-time safe.
+  void activate()
+  {
+    generation_.fetch_add(1, boost::memory_order_release);
+    active_.store(true, boost::memory_order_release);
+  }
+
+  /// Stop processing requests. Pending ones, and their results, are discarded. Real-time safe.
+  void deactivate()
+  {
+    active_.store(false, boost::memory_order_release);
+    notify();
+  }
+
+  void run()
+  {
+    while (true)
+    {
+      while (sem_wait(&semaphore_) != 0 && errno == EINTR) {}
+      if (shutdown_.load(boost::memory_order_acquire))
+        break;
+      process();
+    }
+  }
+
+  boost::thread thread_;
+  sem_t semaphore_;
+  boost::atomic<bool> active_;
+  boost::atomic<bool> shutdown_;
+  boost::atomic<boost::uint32_t> generation_;
+
+  boost::atomic<boost::uint64_t> num_requests_;
+  boost::atomic<double> max_compute_time_;
+  boost::atomic<double> mean_compute_time_;
+};
+
+/** \brief Non-realtime worker thread of a controller, with lock-free mailboxes
+ *
+ * Controllers with expensive computations (eg. inverse kinematics or
+ * trajectory re-planning) can offload them to a worker, so that they don't
+ * overrun the control cycle. The real-time thread posts requests with
+ * \ref trySubmit and collects results with \ref tryReceive. Neither call
+ * blocks: both mailboxes are bounded single-producer, single-consumer
+ * lock-free queues. Requests are processed by \ref compute in the worker
+ * thread, in submission order.
+ *
+ * To use a worker, derive from this class, implement \ref compute, and attach
+ * an instance to the controller with \ref ControllerBase::setWorker (eg. from
+ * \c init). \ref compute must only use the request and the worker's own data,
+ * and not the controller's, as the worker may outlive the controller members.
+ *
+ * \tparam Request Type of the requests. Must be default-constructible and copyable.
+ * \tparam Result Type of the results. Must be default-constructible and copyable.
+ */
+template <class Request, class Result>
+class ControllerWorker : public ControllerWorkerBase
+{
+public:
+  /** \param capacity Number of requests, and of results, each mailbox can hold. Not real-time safe. */
+  explicit ControllerWorker(std::size_t capacity = 16)
+    : requests_(capacity),
+      results_(capacity)
+  {}
+
+  /** \name Real-Time Safe Functions
+   *\{*/
+
+  /** \brief Submit a request to the worker
+   *
+   * \returns False if the controller is not running or the request mailbox is full
+   */
+  bool trySubmit(const Request& request)
+  {
+    if (!isActive() || !requests_.push(Stamped<Request>(getGeneration(), request)))
+      return false;
+    notify();
+    return true;
+  }
+
+  /** \brief Receive the oldest result not received yet
+   *
+   * \returns False if there is no result available
+   */
+  bool tryReceive(Result& result)
+  {
+    // Results computed before the controller was last restarted are dropped
+    Stamped<Result> stamped;
+    while (results_.pop(stamped))
+    {
+      if (stamped.generation == getGeneration())
+      {
+        result = stamped.value;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /*\}*/
+
+protected:
+  /** \brief Process a request. Called from the worker thread.
+   *
+   * \returns True if \c result should be delivered to the controller
+   */
+  virtual bool compute(const Request& request, Result& result) = 0;
+
+private:
+  /// A request or result, with the activation generation it belongs to
+  template <class T>
+  struct Stamped
+  {
+    Stamped() : generation(0), value() {}
+    Stamped(boost::uint32_t generation, const T& value) : generation(generation), value(value) {}
+
+    boost::uint32_t generation;
+    T value;
+  };
+
+  virtual void process()
+  {
+    Stamped<Request> request;
+    Stamped<Result> result;
+    while (requests_.pop(request))
+    {
+      // Requests submitted before the controller was stopped are dropped
+      if (!isCurrent(request.generation))
+        continue;
+
+      const ros::WallTime start = ros::WallTime::now();
+      const bool deliver = compute(request.value, result.value);
+      recordComputeTime((ros::WallTime::now() - start).toSec());
+
+      // Results are dropped if the controller doesn't keep up with them
+      result.generation = request.generation;
+      if (deliver && isCurrent(result.generation))
+        results_.push(result);
+    }
+  }
+
+  /// \returns True if the controller is running in the given activation generation
+  bool isCurrent(boost::uint32_t generation) const
+  {
+    return isActive() && generation == getGeneration();
+  }
+
+  boost::lockfree::spsc_queue<Stamped<Request> > requests_;
+  boost::lockfree::spsc_queue<Stamped<Result> > results_;
+};
+
+}
+
+#endif
@@ -0,0 +1,141 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2012, hiDOF INC.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of hiDOF, Inc. nor the names of its
+//     contributors may be used to endorse or promote products derived from
+//     this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef CONTROLLER_INTERFACE_EXPORTED_INTERFACE_H
+#define CONTROLLER_INTERFACE_EXPORTED_INTERFACE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <hardware_interface/internal/demangle_symbol.h>
+#include <hardware_interface/internal/hardware_resource_manager.h>
+
+
+namespace controller_interface
+{
+
+/** \brief Hardware interface exported by a controller to other controllers
+ *
+ * This is the type-independent view of an interface that a controller makes
+ * available to the controllers downstream of it in a cascade. The controller
+ * manager uses it to merge the handles of all the interfaces of a given type
+ * (those of the robot hardware and those exported by controllers) into a
+ * single interface instance. See \ref ControllerBase::exportInterface.
+ */
+class ExportedInterfaceBase
+{
+public:
+  virtual ~ExportedInterfaceBase() {}
+
+  /// The demangled name of the hardware interface type
+  virtual std::string getName() const = 0;
+
+  /** \brief Get the names of the resources (ie. handles) of an interface of the exported type
+   *
+   * \param iface The interface. If NULL, the resources of the exported interface are returned.
+   */
+  virtual std::vector<std::string> getResources(hardware_interface::HardwareInterface* iface = NULL) const = 0;
+
+  /// Create an empty hardware interface of the exported type
+  virtual hardware_interface::HardwareInterface* create() const = 0;
+
+  /// Remove all handles and claims from \c iface, an interface of the exported type
+  virtual void clear(hardware_interface::HardwareInterface* iface) const = 0;
+
+  /** \brief Copy all handles from one interface of the exported type to another
+   *
+   * \param from The interface to copy handles from. If NULL, the handles of
+   * the exported interface are copied.
+   * \param to The interface to copy handles to
+   */
+  virtual void copyHandles(hardware_interface::HardwareInterface* from,
+                           hardware_interface::HardwareInterface* to) const = 0;
+};
+
+namespace internal
+{
+
+template <class ResourceHandle, class ClaimPolicy>
+void copyHandles(hardware_interface::HardwareResourceManager<ResourceHandle, ClaimPolicy>& from,
+                 hardware_interface::HardwareResourceManager<ResourceHandle, ClaimPolicy>& to)
+{
+  // Bypass the claim policy, copying handles does not use resources
+  hardware_interface::ResourceManager<ResourceHandle>& resources = from;
+  const std::vector<std::string> names = resources.getNames();
+  for (size_t i = 0; i < names.size(); ++i)
+    to.registerHandle(resources.getHandle(names[i]));
+}
+
+}
+
+/** \brief Hardware interface exported by a controller to other controllers
+ *
+ * \tparam T The hardware interface type. It must derive from
+ * \ref hardware_interface::HardwareResourceManager, as eg.
+ * \ref hardware_interface::JointCommandInterface does.
+ */
+template <class T>
+class ExportedInterface : public ExportedInterfaceBase
+{
+public:
+  /** \param iface The exported interface. It is owned by the exporting controller. */
+  explicit ExportedInterface(T* iface) : iface_(iface) {}
+
+  virtual std::string getName() const
+  {
+    return hardware_interface::internal::demangledTypeName<T>();
+  }
+
+  virtual std::vector<std::string> getResources(hardware_interface::HardwareInterface* iface = NULL) const
+  {
+    return iface ? static_cast<T*>(iface)->getNames() : iface_->getNames();
+  }
+
+  virtual hardware_interface::HardwareInterface* create() const
+  {
+    return new T;
+  }
+
+  virtual void clear(hardware_interface::HardwareInterface* iface) const
+  {
+    *static_cast<T*>(iface) = T();
+  }
+
+  virtual void copyHandles(hardware_interface::HardwareInterface* from,
+                           hardware_interface::HardwareInterface* to) const
+  {
+    internal::copyHandles(from ? *static_cast<T*>(from) : *iface_, *static_cast<T*>(to));
+  }
+
+private:
+  T* iface_;
+};
+
+}
+
+#endif
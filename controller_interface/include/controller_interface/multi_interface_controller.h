@@ -0,0 +1,256 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2012, hiDOF INC.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of hiDOF, Inc. nor the names of its
+//     contributors may be used to endorse or promote products derived from
+//     this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef CONTROLLER_INTERFACE_MULTI_INTERFACE_CONTROLLER_H
+#define CONTROLLER_INTERFACE_MULTI_INTERFACE_CONTROLLER_H
+
+#include <set>
+#include <string>
+#include <controller_interface/controller_base.h>
+#include <hardware_interface/internal/demangle_symbol.h>
+#include <hardware_interface/robot_hw.h>
+#include <hardware_interface/hardware_interface.h>
+#include <ros/ros.h>
+
+
+namespace controller_interface
+{
+
+namespace internal
+{
+
+/// Placeholder for the unused hardware interface slots of a \ref MultiInterfaceController
+struct NoInterface {};
+
+/** \brief Operations on one of the hardware interfaces of a \ref MultiInterfaceController
+ *
+ * \tparam T The hardware interface type
+ */
+template <class T>
+struct InterfaceSlot
+{
+  /// Make the interface of \c robot_hw available in \c robot_hw_ctrl. Returns false if \c robot_hw lacks it
+  static bool extract(hardware_interface::RobotHW* robot_hw, hardware_interface::RobotHW& robot_hw_ctrl)
+  {
+    T* hw = robot_hw->get<T>();
+    if (!hw)
+    {
+      ROS_ERROR("This controller requires a hardware interface of type '%s'."
+                " Make sure this is registered in the hardware_interface::RobotHW class.",
+                getName().c_str());
+      return false;
+    }
+    robot_hw_ctrl.registerInterface(hw);
+    return true;
+  }
+
+  static void clearClaims(hardware_interface::RobotHW& robot_hw_ctrl)
+  {
+    robot_hw_ctrl.get<T>()->clearClaims();
+  }
+
+  /// Add the resources claimed through the interface to \c claimed_resources
+  static void mergeClaims(hardware_interface::RobotHW& robot_hw_ctrl, std::set<std::string>& claimed_resources)
+  {
+    const std::set<std::string> claims = robot_hw_ctrl.get<T>()->getClaims();
+    claimed_resources.insert(claims.begin(), claims.end());
+  }
+
+  static std::string getName()
+  {
+    return hardware_interface::internal::demangledTypeName<T>();
+  }
+};
+
+template <>
+struct InterfaceSlot<NoInterface>
+{
+  static bool extract(hardware_interface::RobotHW*, hardware_interface::RobotHW&) {return true;}
+  static void clearClaims(hardware_interface::RobotHW&) {}
+  static void mergeClaims(hardware_interface::RobotHW&, std::set<std::string>&) {}
+  static std::string getName() {return std::string();}
+};
+
+}
+
+/** \brief %Controller using several hardware interfaces at once
+ *
+ * Unlike \ref Controller, which is bound to a single hardware interface type,
+ * this controller can use up to four of them, eg. a command interface
+ * together with the sensor interfaces it needs for feedback. All interfaces
+ * must be registered in the robot hardware for the controller to be
+ * initialized. The resources claimed through any of them are merged for
+ * conflict checking.
+ *
+ * \code
+ * class MyController : public controller_interface::MultiInterfaceController<
+ *   hardware_interface::EffortJointInterface, hardware_interface::ImuSensorInterface>
+ * {
+ *   bool init(hardware_interface::RobotHW* robot_hw, ros::NodeHandle& controller_nh)
+ *   {
+ *     hardware_interface::EffortJointInterface* effort_hw = robot_hw->get<hardware_interface::EffortJointInterface>();
+ *     hardware_interface::ImuSensorInterface* imu_hw = robot_hw->get<hardware_interface::ImuSensorInterface>();
+ *     // ...
+ *   }
+ * };
+ * \endcode
+ *
+ * \tparam T1 The first hardware interface type used by this controller.
+ * \tparam T2 The second hardware interface type used by this controller.
+ * \tparam T3 The (optional) third hardware interface type used by this controller.
+ * \tparam T4 The (optional) fourth hardware interface type used by this controller.
+ */
+template <class T1, class T2, class T3 = internal::NoInterface, class T4 = internal::NoInterface>
+class MultiInterfaceController: public ControllerBase
+{
+public:
+  MultiInterfaceController()  {}
+  virtual ~MultiInterfaceController(){}
+
+  /** \brief The init function is called to initialize the controller from a
+   * non-realtime thread.
+   *
+   * \param robot_hw A robot hardware abstraction that contains only the
+   * hardware interfaces used by this controller. It remains valid for the
+   * lifetime of the controller.
+   *
+   * \param controller_nh A NodeHandle in the namespace from which the controller
+   * should read its configuration, and where it should set up its ROS
+   * interface.
+   *
+   * \returns True if initialization was successful and the controller
+   * is ready to be started.
+   */
+  virtual bool init(hardware_interface::RobotHW* robot_hw, ros::NodeHandle &controller_nh) {return true;};
+
+  /** \brief The init function is called to initialize the controller from a
+   * non-realtime thread.
+   *
+   * \param robot_hw A robot hardware abstraction that contains only the
+   * hardware interfaces used by this controller. It remains valid for the
+   * lifetime of the controller.
+   *
+   * \param root_nh A NodeHandle in the root of the controller manager namespace.
+   * This is where the ROS interfaces are setup (publishers, subscribers, services).
+   *
+   * \param controller_nh A NodeHandle in the namespace of the controller.
+   * This is where the controller-specific configuration resides.
+   *
+   * \returns True if initialization was successful and the controller
+   * is ready to be started.
+   */
+  virtual bool init(hardware_interface::RobotHW* robot_hw, ros::NodeHandle& root_nh, ros::NodeHandle &controller_nh)
+  {return true;};
+
+
+protected:
+  /** \brief Initialize the controller from a RobotHW pointer
+   *
+   * This calls \ref init with a robot hardware abstraction restricted to the
+   * hardware interfaces of this controller, if it can extract all of them
+   * from \c robot_hw. The real-time memory arena of the controller, if any,
+   * is set up before.
+   *
+   */
+  virtual bool initRequest(hardware_interface::RobotHW* robot_hw,
+                           ros::NodeHandle& root_nh, ros::NodeHandle &controller_nh,
+                           std::set<std::string> &claimed_resources)
+  {
+    // check if construction finished cleanly
+    if (getState() != CONSTRUCTED){
+      ROS_ERROR("Cannot initialize this controller because it failed to be constructed");
+      return false;
+    }
+
+    // get pointers to all the hardware interfaces
+    if (!internal::InterfaceSlot<T1>::extract(robot_hw, robot_hw_ctrl_) ||
+        !internal::InterfaceSlot<T2>::extract(robot_hw, robot_hw_ctrl_) ||
+        !internal::InterfaceSlot<T3>::extract(robot_hw, robot_hw_ctrl_) ||
+        !internal::InterfaceSlot<T4>::extract(robot_hw, robot_hw_ctrl_))
+      return false;
+
+    // set up the real-time memory arena, so that it's available to init
+    if (!initArena(controller_nh))
+      return false;
+
+    // return which resources are claimed by this controller, through any of its interfaces
+    clearClaims();
+    if (!init(&robot_hw_ctrl_, controller_nh) || !init(&robot_hw_ctrl_, root_nh, controller_nh))
+    {
+      ROS_ERROR("Failed to initialize the controller");
+      clearClaims();
+      return false;
+    }
+    claimed_resources.clear();
+    internal::InterfaceSlot<T1>::mergeClaims(robot_hw_ctrl_, claimed_resources);
+    internal::InterfaceSlot<T2>::mergeClaims(robot_hw_ctrl_, claimed_resources);
+    internal::InterfaceSlot<T3>::mergeClaims(robot_hw_ctrl_, claimed_resources);
+    internal::InterfaceSlot<T4>::mergeClaims(robot_hw_ctrl_, claimed_resources);
+    clearClaims();
+
+    // success
+    setState(INITIALIZED);
+    return true;
+  }
+
+  /// Get the names of this controller's hardware interface types, separated by commas
+  virtual std::string getHardwareInterfaceType() const
+  {
+    std::string type = internal::InterfaceSlot<T1>::getName();
+    appendName(type, internal::InterfaceSlot<T2>::getName());
+    appendName(type, internal::InterfaceSlot<T3>::getName());
+    appendName(type, internal::InterfaceSlot<T4>::getName());
+    return type;
+  }
+
+private:
+  void clearClaims()
+  {
+    internal::InterfaceSlot<T1>::clearClaims(robot_hw_ctrl_);
+    internal::InterfaceSlot<T2>::clearClaims(robot_hw_ctrl_);
+    internal::InterfaceSlot<T3>::clearClaims(robot_hw_ctrl_);
+    internal::InterfaceSlot<T4>::clearClaims(robot_hw_ctrl_);
+  }
+
+  static void appendName(std::string& type, const std::string& name)
+  {
+    if (!name.empty())
+      type += ", " + name;
+  }
+
+  /// Robot hardware abstraction restricted to the hardware interfaces of this controller
+  hardware_interface::RobotHW robot_hw_ctrl_;
+
+  MultiInterfaceController(const MultiInterfaceController &c);
+  MultiInterfaceController& operator =(const MultiInterfaceController &c);
+
+};
+
+}
+
+#endif
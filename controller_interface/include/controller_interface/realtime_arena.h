@@ -0,0 +1,240 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2012, hiDOF INC.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of hiDOF, Inc. nor the names of its
+//     contributors may be used to endorse or promote products derived from
+//     this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef CONTROLLER_INTERFACE_REALTIME_ARENA_H
+#define CONTROLLER_INTERFACE_REALTIME_ARENA_H
+
+#include <cstddef>
+#include <cstring>
+#include <sys/mman.h>
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+
+
+namespace controller_interface
+{
+
+/** \brief Bounded memory arena for the real-time scratch memory of a controller
+ *
+ * The arena reserves all of its memory up front, so that controllers can
+ * allocate and release blocks from their real-time \ref ControllerBase::update
+ * method in constant time, without calling into the system allocator.
+ *
+ * Block sizes are rounded up to the next power of two (at least 16 bytes, which
+ * is also the alignment of all blocks), and that rounded size is what counts
+ * against the capacity. The largest block an arena can serve is thus the
+ * largest power of two that fits in it: an arena of 1000 bytes cannot serve a
+ * request of 600 bytes, which needs a 1024 byte block. Size arenas for the
+ * rounded sizes of the blocks they must hold at once. Released blocks are kept in one free
+ * list per block size and reused by later requests of the same size class.
+ * Requests that cannot be served from a free list are carved from the unused
+ * part of the arena. Memory is only returned wholesale, by \ref reset or when
+ * the arena is destroyed.
+ *
+ * The arena itself is not thread-safe: it must be used from one thread at a
+ * time, typically the real-time thread. Its usage figures can however be read
+ * from any thread.
+ */
+class RealtimeArena : private boost::noncopyable
+{
+public:
+  /**
+   * The memory of the arena is touched here, so that the real-time thread does
+   * not take page faults on first use, and locked in RAM if the process is
+   * allowed to. Not real-time safe.
+   *
+   * \param capacity Size of the arena, in bytes.
+   */
+  explicit RealtimeArena(std::size_t capacity)
+    : capacity_(roundUp(capacity, MIN_BLOCK_SIZE)),
+      buffer_(new char[capacity_]),
+      locked_(false),
+      offset_(0),
+      used_(0),
+      high_water_mark_(0)
+  {
+    std::memset(buffer_, 0, capacity_);
+    locked_ = (mlock(buffer_, capacity_) == 0);
+    clearFreeLists();
+  }
+
+  ~RealtimeArena()
+  {
+    if (locked_)
+      munlock(buffer_, capacity_);
+    delete[] buffer_;
+  }
+
+  /** \name Real-Time Safe Functions
+   *\{*/
+
+  /** \brief Allocate a block of memory
+   *
+   * \param size Size of the block, in bytes.
+   * \returns A pointer to the block, or NULL if the arena is exhausted.
+   */
+  void* allocate(std::size_t size)
+  {
+    if (size > capacity_)
+      return NULL;
+
+    const unsigned int size_class = getSizeClass(size);
+    const std::size_t block_size = getBlockSize(size_class);
+
+    void* block;
+    if (free_lists_[size_class])
+    {
+      FreeBlock* free_block = free_lists_[size_class];
+      free_lists_[size_class] = free_block->next;
+      block = free_block;
+    }
+    else if (block_size <= capacity_ - offset_)
+    {
+      block = buffer_ + offset_;
+      offset_ += block_size;
+    }
+    else
+      return NULL;
+
+    const std::size_t used = used_.load(boost::memory_order_relaxed) + block_size;
+    used_.store(used, boost::memory_order_relaxed);
+    if (used > high_water_mark_.load(boost::memory_order_relaxed))
+      high_water_mark_.store(used, boost::memory_order_relaxed);
+    return block;
+  }
+
+  /** \brief Release a block of memory obtained from \ref allocate
+   *
+   * \param ptr Pointer to the block. Releasing NULL is a no-op.
+   * \param size Size of the block, in bytes, as passed to \ref allocate.
+   */
+  void deallocate(void* ptr, std::size_t size)
+  {
+    if (!ptr)
+      return;
+
+    const unsigned int size_class = getSizeClass(size);
+    FreeBlock* free_block = static_cast<FreeBlock*>(ptr);
+    free_block->next = free_lists_[size_class];
+    free_lists_[size_class] = free_block;
+
+    used_.store(used_.load(boost::memory_order_relaxed) - getBlockSize(size_class), boost::memory_order_relaxed);
+  }
+
+  /** \brief Allocate uninitialized storage for \c n objects of type \c T
+   *
+   * \returns A pointer to the storage, or NULL if the arena is exhausted.
+   */
+  template <class T>
+  T* allocateArray(std::size_t n)
+  {
+    return static_cast<T*>(allocate(n * sizeof(T)));
+  }
+
+  /// Release storage obtained from \ref allocateArray
+  template <class T>
+  void deallocateArray(T* ptr, std::size_t n)
+  {
+    deallocate(ptr, n * sizeof(T));
+  }
+
+  /** \brief Reclaim all the memory of the arena at once
+   *
+   * All blocks allocated so far become invalid. The high-water mark is kept.
+   */
+  void reset()
+  {
+    offset_ = 0;
+    clearFreeLists();
+    used_.store(0, boost::memory_order_relaxed);
+  }
+
+  /*\}*/
+
+  /** \name Usage Statistics
+   * These can be read from any thread.
+   *\{*/
+
+  /// Size of the arena, in bytes
+  std::size_t getCapacity() const {return capacity_;}
+
+  /// Number of bytes currently allocated, including the rounding of block sizes
+  std::size_t getUsed() const {return used_.load(boost::memory_order_relaxed);}
+
+  /// Largest number of bytes ever allocated at once
+  std::size_t getHighWaterMark() const {return high_water_mark_.load(boost::memory_order_relaxed);}
+
+  /*\}*/
+
+private:
+  static const std::size_t MIN_BLOCK_SIZE = 16;
+  static const unsigned int SIZE_CLASS_COUNT = sizeof(std::size_t) * 8 - 4; // Largest block size still fits a size_t
+
+  struct FreeBlock
+  {
+    FreeBlock* next;
+  };
+
+  static std::size_t roundUp(std::size_t value, std::size_t multiple)
+  {
+    return ((value + multiple - 1) / multiple) * multiple;
+  }
+
+  /// Index of the smallest power-of-two block size that fits \c size bytes. Takes a bounded number of steps
+  static unsigned int getSizeClass(std::size_t size)
+  {
+    unsigned int size_class = 0;
+    while (getBlockSize(size_class) < size && size_class + 1 < SIZE_CLASS_COUNT)
+      ++size_class;
+    return size_class;
+  }
+
+  static std::size_t getBlockSize(unsigned int size_class)
+  {
+    return MIN_BLOCK_SIZE << size_class;
+  }
+
+  void clearFreeLists()
+  {
+    for (unsigned int i = 0; i < SIZE_CLASS_COUNT; ++i)
+      free_lists_[i] = NULL;
+  }
+
+  std::size_t capacity_;
+  char* buffer_;
+  bool locked_; ///< Whether the buffer could be locked in RAM
+  std::size_t offset_;
+  FreeBlock* free_lists_[SIZE_CLASS_COUNT];
+
+  boost::atomic<std::size_t> used_;
+  boost::atomic<std::size_t> high_water_mark_;
+};
+
+}
+
+#endif
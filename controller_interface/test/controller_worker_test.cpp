@@ -0,0 +1,234 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2012, hiDOF INC.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of hiDOF, Inc. nor the names of its
+//     contributors may be used to endorse or promote products derived from
+//     this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//////////////////////////////////////////////////////////////////////////////
+
+#include <set>
+#include <string>
+#include <gtest/gtest.h>
+#include <boost/atomic.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <controller_interface/controller_base.h>
+
+using namespace controller_interface;
+
+/// Doubles its requests, and can be held in the middle of a computation
+class DoublingWorker : public ControllerWorker<int, int>
+{
+public:
+  DoublingWorker() : held_(false), computing_(false) {}
+
+  void hold()
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    held_ = true;
+  }
+
+  void release()
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    held_ = false;
+    released_.notify_all();
+  }
+
+  bool isComputing() const {return computing_.load();}
+
+protected:
+  virtual bool compute(const int& request, int& result)
+  {
+    computing_.store(true);
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      while (held_)
+        released_.wait(lock);
+    }
+    result = 2 * request;
+    computing_.store(false);
+    return true;
+  }
+
+private:
+  boost::mutex mutex_;
+  boost::condition_variable released_;
+  bool held_;
+  boost::atomic<bool> computing_;
+};
+
+class WorkerTestController : public ControllerBase
+{
+public:
+  explicit WorkerTestController(ControllerWorkerBase* worker)
+  {
+    setWorker(worker);
+  }
+
+  virtual void update(const ros::Time&, const ros::Duration&) {}
+
+  virtual std::string getHardwareInterfaceType() const {return "";}
+
+  virtual bool initRequest(hardware_interface::RobotHW*, ros::NodeHandle&, ros::NodeHandle&,
+                           std::set<std::string>&)
+  {
+    setState(INITIALIZED);
+    return true;
+  }
+
+  void init()
+  {
+    setState(INITIALIZED);
+  }
+
+  void replaceWorker(ControllerWorkerBase* worker)
+  {
+    setWorker(worker);
+  }
+};
+
+class ControllerWorkerTest : public ::testing::Test
+{
+public:
+  ControllerWorkerTest()
+    : worker(new DoublingWorker()),
+      controller(worker)
+  {
+    controller.init();
+  }
+
+protected:
+  DoublingWorker* worker;
+  WorkerTestController controller;
+  ros::Time time;
+
+  /// Poll the worker for a result, for up to a few seconds
+  bool waitForResult(int& result)
+  {
+    for (int i = 0; i < 5000; ++i)
+    {
+      if (worker->tryReceive(result))
+        return true;
+      boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    }
+    return false;
+  }
+
+  /// Wait for the worker thread to enter a computation
+  bool waitForComputing()
+  {
+    for (int i = 0; i < 5000 && !worker->isComputing(); ++i)
+      boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    return worker->isComputing();
+  }
+};
+
+TEST_F(ControllerWorkerTest, SubmitAndReceive)
+{
+  // Requests are rejected while the controller is not running
+  EXPECT_FALSE(worker->trySubmit(1));
+
+  ASSERT_TRUE(controller.startRequest(time));
+  EXPECT_TRUE(worker->trySubmit(1));
+  EXPECT_TRUE(worker->trySubmit(2));
+
+  // Results arrive in submission order
+  int result = 0;
+  ASSERT_TRUE(waitForResult(result));
+  EXPECT_EQ(2, result);
+  ASSERT_TRUE(waitForResult(result));
+  EXPECT_EQ(4, result);
+  EXPECT_FALSE(worker->tryReceive(result));
+  EXPECT_EQ(2u, worker->getNumRequests());
+
+  // Requests are rejected again once the controller is stopped
+  ASSERT_TRUE(controller.stopRequest(time));
+  EXPECT_FALSE(worker->trySubmit(3));
+}
+
+TEST_F(ControllerWorkerTest, StopStartDiscardsPendingWork)
+{
+  ASSERT_TRUE(controller.startRequest(time));
+
+  // One request is being computed, and another one is queued behind it
+  worker->hold();
+  EXPECT_TRUE(worker->trySubmit(1));
+  ASSERT_TRUE(waitForComputing());
+  EXPECT_TRUE(worker->trySubmit(2));
+
+  // Restart the controller before the worker gets to them
+  ASSERT_TRUE(controller.stopRequest(time));
+  ASSERT_TRUE(controller.startRequest(time));
+  worker->release();
+
+  // Only the request submitted after the restart yields a result
+  EXPECT_TRUE(worker->trySubmit(3));
+  int result = 0;
+  ASSERT_TRUE(waitForResult(result));
+  EXPECT_EQ(6, result);
+  EXPECT_FALSE(worker->tryReceive(result));
+
+  // The request queued before the restart was not even computed
+  EXPECT_EQ(2u, worker->getNumRequests());
+}
+
+TEST_F(ControllerWorkerTest, Shutdown)
+{
+  ASSERT_TRUE(controller.startRequest(time));
+  for (int i = 0; i < 10; ++i)
+    worker->trySubmit(i);
+
+  // Replacing the worker joins the thread of the previous one before destroying it
+  DoublingWorker* new_worker = new DoublingWorker();
+  controller.replaceWorker(new_worker);
+  worker = new_worker;
+
+  // The new worker only starts processing once the controller is started
+  EXPECT_FALSE(worker->trySubmit(1));
+  ASSERT_TRUE(controller.stopRequest(time));
+  ASSERT_TRUE(controller.startRequest(time));
+  EXPECT_TRUE(worker->trySubmit(1));
+  int result = 0;
+  ASSERT_TRUE(waitForResult(result));
+  EXPECT_EQ(2, result);
+}
+
+TEST(ControllerWorkerShutdownTest, DestroyControllerWithPendingRequests)
+{
+  DoublingWorker* worker = new DoublingWorker();
+  WorkerTestController* controller = new WorkerTestController(worker);
+  controller->init();
+  ASSERT_TRUE(controller->startRequest(ros::Time()));
+  for (int i = 0; i < 10; ++i)
+    worker->trySubmit(i);
+
+  // The controller joins the worker thread before the worker is destroyed
+  delete controller;
+  SUCCEED();
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -28,6 +28,8 @@
 #ifndef CONRTOLLER_MANAGER_CONTROLLER_LOADER_H
 #define CONRTOLLER_MANAGER_CONTROLLER_LOADER_H
 
+#include <string>
+#include <vector>
 #include <pluginlib/class_loader.h>
 #include <controller_manager/controller_loader_interface.h>
 #include <boost/shared_ptr.hpp>
@@ -71,6 +73,28 @@ public:
     controller_loader_.reset(new pluginlib::ClassLoader<T>(package_, base_class_) );
   }
 
+  std::vector<std::string> getLibraryClasses(const std::string& lookup_name)
+  {
+    const std::string library = controller_loader_->getClassLibraryPath(lookup_name);
+    const std::vector<std::string> declared = controller_loader_->getDeclaredClasses();
+    std::vector<std::string> classes;
+    for (size_t i = 0; i < declared.size(); ++i)
+    {
+      if (declared[i] == lookup_name || controller_loader_->getClassLibraryPath(declared[i]) == library)
+        classes.push_back(declared[i]);
+    }
+    return classes;
+  }
+
+  bool reloadLibrary(const std::string& lookup_name)
+  {
+    // The library is loaded again by the next createInstance, with the plugin descriptions as they are now
+    if (controller_loader_->isClassLoaded(lookup_name))
+      controller_loader_->unloadLibraryForClass(lookup_name);
+    controller_loader_->refreshDeclaredClasses();
+    return !controller_loader_->isClassLoaded(lookup_name);
+  }
+
 private:
   std::string package_;
   std::string base_class_;
@@ -53,6 +53,27 @@ public:
   virtual boost::shared_ptr<controller_interface::ControllerBase> createInstance(const std::string& lookup_name) = 0;
   virtual std::vector<std::string> getDeclaredClasses() = 0;
   virtual void reload() = 0;
+
+  /** \brief Get the controller types provided by the same library as a given type
+   *
+   * \param lookup_name The controller type
+   * \returns The types, including \c lookup_name
+   */
+  virtual std::vector<std::string> getLibraryClasses(const std::string& lookup_name)
+  {
+    return std::vector<std::string>(1, lookup_name);
+  }
+
+  /** \brief Reload the library providing a controller type
+   *
+   * All the controllers of the types provided by that library (see
+   * \ref getLibraryClasses) must have been destroyed beforehand. Loaders that
+   * can't reload individual libraries don't override this.
+   *
+   * \param lookup_name The controller type
+   * \returns True if the library will be loaded anew for the next instance
+   */
+  virtual bool reloadLibrary(const std::string& lookup_name) { return false; }
   const std::string& getName() { return name_; }
   virtual ~ControllerLoaderInterface() { }
 private:
@@ -38,6 +38,7 @@
 #include <cstdio>
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 #include <ros/ros.h>
 #include <tinyxml.h>
@@ -45,15 +46,21 @@
 #include <realtime_tools/realtime_publisher.h>
 #include <ros/node_handle.h>
 #include <pluginlib/class_loader.h>
+#include <controller_manager_msgs/ControllerStates.h>
+#include <controller_manager_msgs/ControllersStatistics.h>
 #include <controller_manager_msgs/ListControllerTypes.h>
 #include <controller_manager_msgs/ListControllers.h>
 #include <controller_manager_msgs/ReloadControllerLibraries.h>
+#include <controller_manager_msgs/ReloadControllerType.h>
 #include <controller_manager_msgs/LoadController.h>
+#include <controller_manager_msgs/ReplaceController.h>
 #include <controller_manager_msgs/UnloadController.h>
 #include <controller_manager_msgs/SwitchController.h>
 #include <boost/thread/condition.hpp>
 #include <boost/thread/recursive_mutex.hpp>
 #include <controller_manager/controller_loader_interface.h>
+#include <controller_manager/controller_reaper.h>
+#include <controller_manager/virtual_robot_hw.h>
 
 
 namespace controller_manager{
@@ -136,12 +143,57 @@ public:
    * started and stopped.  The levels are defined in the
    * controller_manager_msgs/SwitchControllers service as either \c BEST_EFFORT
    * or \c STRICT.  \c BEST_EFFORT means that \ref switchController can still
-   * succeed if a non-existant controller is requested to be stopped or started.
+   * succeed if a non-existant controller is requested to be stopped or started,
+   * or if a controller fails to prepare to start, in which case it is not started.
    */
   bool switchController(const std::vector<std::string>& start_controllers,
                         const std::vector<std::string>& stop_controllers,
                         const int strictness);
 
+  /** \brief Replace a controller with a new instance.
+   *
+   * This loads and initializes a new instance of the controller called \c
+   * name, from its current configuration (which may change its type), while
+   * the old instance keeps running. If the old instance is running, the
+   * real-time thread then stops it and starts the new instance in the same
+   * cycle, calling \ref controller_interface::ControllerBase::takeOver in
+   * between so that the new instance can carry state over. The old instance
+   * is destroyed in the background.
+   *
+   * The new instance is initialized under the name of the old one, since
+   * both share their configuration. A controller thus cannot be replaced
+   * while it advertises services in its namespace: a node can only advertise
+   * a service once, and the old instance would remove it when destroyed.
+   * Services advertised outside the namespace of the controller are not
+   * detected, and must not be used by replaceable controllers. A controller
+   * cannot be replaced either while other controllers claim resources it
+   * exports.
+   *
+   * \param name The name of the controller to replace
+   *
+   * \returns True on success. On failure, the old instance is left untouched.
+   */
+  bool replaceController(const std::string& name);
+
+  /** \brief Reload the library providing a controller type.
+   *
+   * The controllers of all the types provided by that library are stopped in
+   * one real-time cycle, unloaded, and loaded again from the reloaded library,
+   * after which the ones that were running are started again in one cycle.
+   * Controllers of other libraries keep running throughout.
+   *
+   * This fails before touching any controller if a controller of another
+   * library claims resources exported by a controller of this one. If a
+   * controller of the library cannot be unloaded, the ones already unloaded
+   * are loaded again and the ones that were running are restarted, without
+   * reloading the library.
+   *
+   * \param type One of the controller types provided by the library
+   *
+   * \returns True if the library was reloaded and all its controllers restored
+   */
+  bool reloadControllerType(const std::string& type);
+
   /** \brief Get a controller by name.
    *
    * \param name The name of a controller
@@ -168,9 +220,27 @@ public:
 
 private:
   void getControllerNames(std::vector<std::string> &v);
+  bool initController(const std::string& name, ControllerSpec& spec);
+  bool prepareReplacement(const std::vector<ControllerSpec>& controllers, size_t index,
+                          const ControllerSpec& successor);
+  void cleanupStopRequests(const std::vector<controller_interface::ControllerBase*>& controllers);
+  bool restoreControllers(const std::vector<std::string>& names, const std::vector<std::string>& running);
+  struct RunningController;
+  void publishStatistics(const ros::Time& time, const std::vector<RunningController>& running);
+  void layoutStatistics();
+  void getControllerStates(const std::vector<ControllerSpec>& controllers,
+                           std::vector<controller_manager_msgs::ControllerState>& states) const;
+  void publishControllerStates();
+  void updateControllerTypes();
+  bool claimsExportsOf(const ControllerSpec& claimer, const std::string& exporter) const;
+  bool getControllerServices(const std::string& name, std::vector<std::string>& services) const;
+  void orderCascade(std::vector<ControllerSpec>& controllers) const;
 
   hardware_interface::RobotHW* robot_hw_;
 
+  /// The robot hardware plus the interfaces exported by controllers, which is what controllers are initialized with
+  VirtualRobotHW virtual_hw_;
+
   ros::NodeHandle root_nh_, cm_node_;
 
   typedef boost::shared_ptr<ControllerLoaderInterface> LoaderPtr;
@@ -179,6 +249,9 @@ private:
   /** \name Controller Switching
    *\{*/
   std::vector<controller_interface::ControllerBase*> start_request_, stop_request_;
+  /// Pairs of (stopped, started) controllers, where the started one replaces the stopped one
+  std::vector<std::pair<controller_interface::ControllerBase*, controller_interface::ControllerBase*> >
+    takeover_request_;
   bool please_switch_;
   int switch_strictness_;
   /*\}*/
@@ -195,9 +268,64 @@ private:
   int current_controllers_list_;
   /// The index of the controllers list being used in the real-time thread.
   int used_by_realtime_;
+  /// Destroys unloaded controllers, off the service thread
+  ControllerReaper reaper_;
   /*\}*/
 
 
+  /** \name Running Controllers
+   * Dense array of the running controllers, in update order, which is all the
+   * real-time loop iterates. It is double-buffered: when switching controllers,
+   * the non-real-time thread fills the array not in use with the controllers
+   * that will be running, and the real-time thread swaps it in right after
+   * performing the switch. Loading and unloading controllers never changes
+   * which ones are running.
+   *\{*/
+  struct RunningController
+  {
+    controller_interface::ControllerBase* c;
+    ControllerStatistics* stats;
+  };
+  std::vector<RunningController> running_controllers_[2];
+  /// The index of the running controllers array used by the real-time thread
+  int current_running_controllers_;
+  /// Incremented by the real-time thread every time it swaps the running controllers arrays
+  unsigned int running_controllers_generation_;
+  /*\}*/
+
+  /** \name Controller Statistics
+   * Statistics of the running controllers, published from the real-time
+   * thread at most at the rate given by the \c statistics_publish_rate
+   * parameter (zero disables publishing). The non-real-time thread lays out the
+   * message (names and types) after every switch, and the real-time thread
+   * only fills in the numbers, skipping publication until the layout matches
+   * the running controllers.
+   *\{*/
+  realtime_tools::RealtimePublisher<controller_manager_msgs::ControllersStatistics> pub_controller_stats_;
+  ros::Duration statistics_publish_period_;
+  ros::Time last_statistics_publish_time_;
+  /// The running controllers generation the message is laid out for. Protected by the publisher lock
+  unsigned int statistics_generation_;
+  /*\}*/
+
+  /** \name Controller States
+   * Published (latched) whenever a load, unload or switch changes the state of
+   * the controllers, with an incrementing generation number.
+   *\{*/
+  ros::Publisher pub_controller_states_;
+  /*\}*/
+
+  /** \name Snapshots
+   * Read-only copies of the controllers metadata, which queries read without
+   * waiting behind loads and switches. They are replaced (never modified) with
+   * boost::atomic_store, and read with boost::atomic_load.
+   *\{*/
+  /// The last published controller states, replaced on every list swap or switch that changes them
+  boost::shared_ptr<const controller_manager_msgs::ControllerStates> controller_states_;
+  /// The available controller types, replaced when controller loaders are registered or reloaded
+  boost::shared_ptr<const controller_manager_msgs::ListControllerTypes::Response> controller_types_;
+  /*\}*/
+
   /** \name ROS Service API
    *\{*/
   bool listControllerTypesSrv(controller_manager_msgs::ListControllerTypes::Request &req,
@@ -210,11 +338,16 @@ private:
                           controller_manager_msgs::LoadController::Response &resp);
   bool unloadControllerSrv(controller_manager_msgs::UnloadController::Request &req,
                          controller_manager_msgs::UnloadController::Response &resp);
+  bool replaceControllerSrv(controller_manager_msgs::ReplaceController::Request &req,
+                            controller_manager_msgs::ReplaceController::Response &resp);
   bool reloadControllerLibrariesSrv(controller_manager_msgs::ReloadControllerLibraries::Request &req,
                                     controller_manager_msgs::ReloadControllerLibraries::Response &resp);
+  bool reloadControllerTypeSrv(controller_manager_msgs::ReloadControllerType::Request &req,
+                               controller_manager_msgs::ReloadControllerType::Response &resp);
   boost::mutex services_lock_;
   ros::ServiceServer srv_list_controllers_, srv_list_controller_types_, srv_load_controller_;
   ros::ServiceServer srv_unload_controller_, srv_switch_controller_, srv_reload_libraries_;
+  ros::ServiceServer srv_replace_controller_, srv_reload_type_;
   /*\}*/
 };
 
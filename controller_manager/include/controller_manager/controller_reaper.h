@@ -0,0 +1,153 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2012, hiDOF, INC and Willow Garage, Inc
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of Willow Garage Inc, hiDOF Inc, nor the names of its
+//     contributors may be used to endorse or promote products derived from
+//     this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef CONTROLLER_MANAGER_CONTROLLER_REAPER_H
+#define CONTROLLER_MANAGER_CONTROLLER_REAPER_H
+
+#include <pthread.h>
+#include <sched.h>
+#include <cstddef>
+#include <deque>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <ros/console.h>
+#include <controller_interface/controller_base.h>
+
+namespace controller_manager
+{
+
+/** \brief Destroys unloaded controllers in a low-priority background thread
+ *
+ * Controller destructors may take a while (eg. to shut down publishers or
+ * join threads), so the controller manager hands unloaded controllers over to
+ * this reaper instead of destroying them while holding its locks. The queue of
+ * controllers awaiting destruction is bounded: when it is full, controllers
+ * are destroyed right away by the thread that retires them.
+ */
+class ControllerReaper
+{
+public:
+  typedef boost::shared_ptr<controller_interface::ControllerBase> ControllerPtr;
+
+  /** \param capacity Maximum number of controllers awaiting destruction */
+  explicit ControllerReaper(size_t capacity = 16)
+    : capacity_(capacity),
+      busy_(false),
+      shutdown_(false),
+      thread_(&ControllerReaper::run, this)
+  {}
+
+  /// Destroys all the controllers awaiting destruction, and stops the reaper thread
+  ~ControllerReaper()
+  {
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      shutdown_ = true;
+    }
+    cond_.notify_all();
+    thread_.join();
+  }
+
+  /** \brief Hand a controller over for destruction
+   *
+   * The controller is destroyed once all other references to it are gone.
+   *
+   * \param controller The controller, which is reset
+   */
+  void retire(ControllerPtr& controller)
+  {
+    if (!controller)
+      return;
+
+    boost::mutex::scoped_lock lock(mutex_);
+    if (queue_.size() >= capacity_)
+    {
+      lock.unlock();
+      ROS_WARN("Too many unloaded controllers awaiting destruction, destroying controller right away");
+      controller.reset();
+      return;
+    }
+    queue_.push_back(ControllerPtr());
+    queue_.back().swap(controller);
+    cond_.notify_all();
+  }
+
+  /// Wait until all the retired controllers have been destroyed
+  void drain()
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    while (!queue_.empty() || busy_)
+      cond_.wait(lock);
+  }
+
+private:
+  void run()
+  {
+    // Destruction is never urgent, let it yield to everything else
+#ifdef SCHED_IDLE
+    sched_param param;
+    param.sched_priority = 0;
+    if (pthread_setschedparam(pthread_self(), SCHED_IDLE, &param) != 0)
+      ROS_DEBUG("Could not lower the priority of the controller reaper thread");
+#endif
+
+    boost::mutex::scoped_lock lock(mutex_);
+    while (true)
+    {
+      while (queue_.empty() && !shutdown_)
+        cond_.wait(lock);
+      if (queue_.empty())
+        break;
+
+      ControllerPtr controller;
+      controller.swap(queue_.front());
+      queue_.pop_front();
+      busy_ = true;
+
+      lock.unlock();
+      controller.reset();
+      lock.lock();
+
+      busy_ = false;
+      cond_.notify_all();
+    }
+  }
+
+  size_t capacity_;
+  bool busy_;
+  bool shutdown_;
+  std::deque<ControllerPtr> queue_;
+  boost::mutex mutex_;
+  boost::condition cond_;
+  boost::thread thread_; // Last, so that it starts once everything else is initialized
+};
+
+}
+
+#endif
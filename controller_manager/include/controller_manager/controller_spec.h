@@ -35,28 +35,80 @@
 
 #pragma GCC diagnostic ignored "-Wextra"
 
+#include <algorithm>
 #include <map>
 #include <string>
 #include <vector>
 #include <controller_interface/controller_base.h>
 #include <boost/shared_ptr.hpp>
+#include <ros/time.h>
 #include <hardware_interface/controller_info.h>
 
 namespace controller_manager
 {
 
+/** \brief Update Timing Statistics of a Controller
+ *
+ * These are maintained by the real-time thread. Mean and variance are computed
+ * over a sliding window of recent updates, with exponentially decaying weights.
+ *
+ */
+struct ControllerStatistics
+{
+  ControllerStatistics() : max_time(0.0), mean_time(0.0), variance_time(0.0), num_control_loop_overruns(0) {}
+
+  /** \brief Account for one update of the controller. Real-time safe.
+   *
+   * \param time The time of the update
+   * \param update_time The time the update took to complete, in seconds
+   * \param period The control period, in seconds. Updates that take longer are overruns.
+   */
+  void addUpdateTime(const ros::Time& time, double update_time, double period)
+  {
+    static const double weight = 0.01; // Roughly the last hundred updates
+    const double delta = update_time - mean_time;
+    mean_time     += weight * delta;
+    variance_time  = (1.0 - weight) * (variance_time + weight * delta * delta);
+    max_time       = std::max(max_time, update_time);
+    if (update_time > period)
+    {
+      ++num_control_loop_overruns;
+      time_last_control_loop_overrun = time;
+    }
+  }
+
+  double max_time;                          ///< Longest update time, in seconds
+  double mean_time;                         ///< Mean update time, in seconds
+  double variance_time;                     ///< Variance of the update time, in squared seconds
+  int num_control_loop_overruns;            ///< Number of updates that took longer than the control period
+  ros::Time time_last_control_loop_overrun; ///< Time of the last overrun
+};
+
 /** \brief Controller Specification
  *
  * This struct contains both a pointer to a given controller, \ref c, as well
- * as information about the controller, \ref info.
+ * as information about the controller, \ref info, and its update timing
+ * statistics, \ref stats.
  *
  */
 struct ControllerSpec
 {
   hardware_interface::ControllerInfo info;
   boost::shared_ptr<controller_interface::ControllerBase> c;
+  boost::shared_ptr<ControllerStatistics> stats;
 };
 
+/// Swap two controller specifications without copying them
+inline void swap(ControllerSpec& a, ControllerSpec& b)
+{
+  a.info.name.swap(b.info.name);
+  a.info.type.swap(b.info.type);
+  a.info.hardware_interface.swap(b.info.hardware_interface);
+  a.info.resources.swap(b.info.resources);
+  a.c.swap(b.c);
+  a.stats.swap(b.stats);
+}
+
 }
 
 #endif
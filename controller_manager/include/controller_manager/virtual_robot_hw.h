@@ -0,0 +1,237 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2012, hiDOF, INC and Willow Garage, Inc
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of Willow Garage Inc, hiDOF Inc, nor the names of its
+//     contributors may be used to endorse or promote products derived from
+//     this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef CONTROLLER_MANAGER_VIRTUAL_ROBOT_HW_H
+#define CONTROLLER_MANAGER_VIRTUAL_ROBOT_HW_H
+
+#include <algorithm>
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <ros/console.h>
+#include <controller_interface/exported_interface.h>
+#include <hardware_interface/robot_hw.h>
+
+namespace controller_manager
+{
+
+/** \brief Robot hardware extended with the interfaces exported by controllers
+ *
+ * This is the hardware that the controller manager hands to the controllers
+ * it loads. It provides all the interfaces of the robot hardware, plus the
+ * ones exported by the loaded controllers (see
+ * \ref controller_interface::ControllerBase::exportInterface). When both the
+ * robot and controllers provide interfaces of the same type, their handles
+ * are merged into a single interface instance. That instance lives as long as
+ * the virtual hardware, so that pointers to it remain valid: when the last
+ * controller exporting its type is unloaded, it is refilled with the handles
+ * of the robot hardware only.
+ *
+ * Resource conflicts are checked by the robot hardware, to which exported
+ * resources look like any other resource.
+ */
+class VirtualRobotHW : public hardware_interface::RobotHW
+{
+public:
+  typedef std::vector<boost::shared_ptr<controller_interface::ExportedInterfaceBase> > Exports;
+
+  /** \param robot_hw The robot hardware, which must outlive this instance */
+  explicit VirtualRobotHW(hardware_interface::RobotHW* robot_hw) : robot_hw_(robot_hw) {}
+
+  virtual hardware_interface::HardwareInterface* getInterface(const std::string& name) const
+  {
+    MergedMap::const_iterator it = merged_.find(name);
+    return (it != merged_.end() && it->second.exported) ? it->second.iface.get() : robot_hw_->getInterface(name);
+  }
+
+  virtual bool checkForConflict(const std::list<hardware_interface::ControllerInfo>& info) const
+  {
+    return robot_hw_->checkForConflict(info);
+  }
+
+  /** \brief Add the interfaces exported by a controller
+   *
+   * \param controller The name of the exporting controller
+   * \param exports The interfaces it exports
+   * \param claimed_resources The resources the controller claims itself
+   *
+   * \returns False, without adding anything, if an exported resource has the
+   * same name as one of the robot hardware, of another controller, or as one
+   * claimed by the exporting controller
+   */
+  bool addExports(const std::string& controller, const Exports& exports,
+                  const std::set<std::string>& claimed_resources)
+  {
+    std::set<std::string> resources;
+    for (size_t i = 0; i < exports.size(); ++i)
+    {
+      std::vector<std::string> names = exports[i]->getResources();
+      hardware_interface::HardwareInterface* robot_iface = robot_hw_->getInterface(exports[i]->getName());
+      const std::vector<std::string> robot_names = robot_iface ? exports[i]->getResources(robot_iface)
+                                                               : std::vector<std::string>();
+      for (size_t j = 0; j < names.size(); ++j)
+      {
+        const std::string& name = names[j];
+        std::string owner;
+        if (exporters_.count(name))
+          owner = "controller '" + exporters_.find(name)->second + "'";
+        else if (claimed_resources.count(name) || resources.count(name))
+          owner = "controller '" + controller + "'";
+        else if (std::find(robot_names.begin(), robot_names.end(), name) != robot_names.end())
+          owner = "the robot hardware";
+        if (!owner.empty())
+        {
+          ROS_ERROR("Controller '%s' cannot export resource '%s', which is already provided or claimed by %s",
+                    controller.c_str(), name.c_str(), owner.c_str());
+          return false;
+        }
+        resources.insert(name);
+      }
+    }
+
+    std::set<std::string> types;
+    for (size_t i = 0; i < exports.size(); ++i)
+    {
+      exports_.push_back(Export(controller, exports[i]));
+      types.insert(exports[i]->getName());
+    }
+    for (std::set<std::string>::const_iterator it = resources.begin(); it != resources.end(); ++it)
+      exporters_[*it] = controller;
+    for (std::set<std::string>::const_iterator it = types.begin(); it != types.end(); ++it)
+      rebuild(*it);
+    return true;
+  }
+
+  /** \brief Remove the interfaces exported by a controller
+   *
+   * Must be done before the controller is destroyed.
+   *
+   * \param controller The name of the exporting controller
+   */
+  void removeExports(const std::string& controller)
+  {
+    std::set<std::string> types;
+    for (std::list<Export>::iterator it = exports_.begin(); it != exports_.end();)
+    {
+      if (it->controller == controller)
+      {
+        types.insert(it->iface->getName());
+        it = exports_.erase(it);
+      }
+      else
+        ++it;
+    }
+    for (std::map<std::string, std::string>::iterator it = exporters_.begin(); it != exporters_.end();)
+    {
+      if (it->second == controller)
+        exporters_.erase(it++);
+      else
+        ++it;
+    }
+    for (std::set<std::string>::const_iterator it = types.begin(); it != types.end(); ++it)
+      rebuild(*it);
+  }
+
+  /** \brief Get the controller exporting a resource
+   *
+   * \returns The name of the controller, or an empty string if the resource is
+   * not exported by a controller
+   */
+  std::string getExporter(const std::string& resource) const
+  {
+    std::map<std::string, std::string>::const_iterator it = exporters_.find(resource);
+    return (it != exporters_.end()) ? it->second : std::string();
+  }
+
+private:
+  struct Export
+  {
+    Export(const std::string& c, const boost::shared_ptr<controller_interface::ExportedInterfaceBase>& i)
+      : controller(c), iface(i) {}
+
+    std::string controller;
+    boost::shared_ptr<controller_interface::ExportedInterfaceBase> iface;
+  };
+
+  struct Merged
+  {
+    Merged() : exported(false) {}
+
+    boost::shared_ptr<hardware_interface::HardwareInterface> iface;
+    /// Type-specific operations on \c iface. Kept after its exporter is gone, only its robot handles are used then
+    boost::shared_ptr<controller_interface::ExportedInterfaceBase> ops;
+    bool exported; ///< Whether a loaded controller exports handles of this type
+  };
+
+  typedef std::map<std::string, Merged> MergedMap;
+
+  /// Merge the handles of all the interfaces of a type, from the robot hardware and the exporting controllers
+  void rebuild(const std::string& type)
+  {
+    std::vector<const controller_interface::ExportedInterfaceBase*> sources;
+    Merged& merged = merged_[type];
+    for (std::list<Export>::const_iterator it = exports_.begin(); it != exports_.end(); ++it)
+    {
+      if (it->iface->getName() == type)
+      {
+        sources.push_back(it->iface.get());
+        if (!merged.ops)
+          merged.ops = it->iface;
+      }
+    }
+    merged.exported = !sources.empty();
+    if (!merged.ops)
+    {
+      merged_.erase(type);
+      return;
+    }
+
+    // Never destroy the merged interface, controllers may hold pointers to it
+    if (merged.iface)
+      merged.ops->clear(merged.iface.get());
+    else
+      merged.iface.reset(merged.ops->create());
+
+    hardware_interface::HardwareInterface* robot_iface = robot_hw_->getInterface(type);
+    if (robot_iface)
+      merged.ops->copyHandles(robot_iface, merged.iface.get());
+    for (size_t i = 0; i < sources.size(); ++i)
+      sources[i]->copyHandles(NULL, merged.iface.get());
+  }
+
+  hardware_interface::RobotHW* robot_hw_;
+  std::list<Export> exports_;
+  std::map<std::string, std::string> exporters_; ///< Exporting controller of each exported resource
+  MergedMap merged_;                             ///< Merged interface of each exported type
+};
+
+}
+
+#endif
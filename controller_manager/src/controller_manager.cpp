@@ -30,10 +30,13 @@
 
 #include "controller_manager/controller_manager.h"
 #include <algorithm>
+#include <set>
 #include <boost/thread/thread.hpp>
 #include <boost/thread/condition.hpp>
 #include <sstream>
 #include <ros/console.h>
+#include <ros/master.h>
+#include <ros/this_node.h>
 #include <controller_manager/controller_loader.h>
 #include <controller_manager_msgs/ControllerState.h>
 
@@ -42,17 +45,39 @@ namespace controller_manager{
 
 ControllerManager::ControllerManager(hardware_interface::RobotHW *robot_hw, const ros::NodeHandle& nh) :
   robot_hw_(robot_hw),
+  virtual_hw_(robot_hw),
   root_nh_(nh),
   cm_node_(nh, "controller_manager"),
   start_request_(0),
   stop_request_(0),
   please_switch_(false),
   current_controllers_list_(0),
-  used_by_realtime_(-1)
+  used_by_realtime_(-1),
+  current_running_controllers_(0),
+  running_controllers_generation_(0),
+  statistics_generation_(0)
 {
+  // publish controller statistics, if requested
+  double statistics_publish_rate = 1.0;
+  cm_node_.param("statistics_publish_rate", statistics_publish_rate, statistics_publish_rate);
+  if (statistics_publish_rate > 0.0)
+  {
+    statistics_publish_period_ = ros::Duration(1.0 / statistics_publish_rate);
+    pub_controller_stats_.init(cm_node_, "statistics", 1);
+  }
+
+  // publish the (initially empty) controller states
+  pub_controller_states_ = cm_node_.advertise<controller_manager_msgs::ControllerStates>("controller_states", 1, true);
+  boost::shared_ptr<controller_manager_msgs::ControllerStates> states(new controller_manager_msgs::ControllerStates);
+  states->header.stamp = ros::Time::now();
+  states->generation = 0;
+  controller_states_ = states;
+  pub_controller_states_.publish(*states);
+
   // create controller loader
   controller_loaders_.push_back( LoaderPtr(new ControllerLoader<controller_interface::ControllerBase>("controller_interface",
                                                                                                       "controller_interface::ControllerBase") ) );
+  updateControllerTypes();
 
   // Advertise services (this should be the last thing we do in init)
   srv_list_controllers_ = cm_node_.advertiseService("list_controllers", &ControllerManager::listControllersSrv, this);
@@ -61,6 +86,8 @@ ControllerManager::ControllerManager(hardware_interface::RobotHW *robot_hw, cons
   srv_unload_controller_ = cm_node_.advertiseService("unload_controller", &ControllerManager::unloadControllerSrv, this);
   srv_switch_controller_ = cm_node_.advertiseService("switch_controller", &ControllerManager::switchControllerSrv, this);
   srv_reload_libraries_ = cm_node_.advertiseService("reload_controller_libraries", &ControllerManager::reloadControllerLibrariesSrv, this);
+  srv_replace_controller_ = cm_node_.advertiseService("replace_controller", &ControllerManager::replaceControllerSrv, this);
+  srv_reload_type_ = cm_node_.advertiseService("reload_controller_type", &ControllerManager::reloadControllerTypeSrv, this);
 }
 
 
@@ -74,22 +101,25 @@ ControllerManager::~ControllerManager()
 void ControllerManager::update(const ros::Time& time, const ros::Duration& period, bool reset_controllers)
 {
   used_by_realtime_ = current_controllers_list_;
-  std::vector<ControllerSpec> &controllers = controllers_lists_[used_by_realtime_];
+  const std::vector<RunningController> &running = running_controllers_[current_running_controllers_];
 
   // Restart all running controllers if motors are re-enabled
   if (reset_controllers){
-    for (size_t i=0; i<controllers.size(); i++){
-      if (controllers[i].c->isRunning()){
-        controllers[i].c->stopRequest(time);
-        controllers[i].c->startRequest(time);
-      }
+    for (size_t i=0; i<running.size(); i++){
+      running[i].c->stopRequest(time);
+      running[i].c->startRequest(time);
     }
   }
 
 
-  // Update all controllers
-  for (size_t i=0; i<controllers.size(); i++)
-    controllers[i].c->updateRequest(time, period);
+  // Update all running controllers, keeping track of the time they take
+  for (size_t i=0; i<running.size(); i++)
+  {
+    const ros::WallTime update_start = ros::WallTime::now();
+    running[i].c->updateRequest(time, period);
+    running[i].stats->addUpdateTime(time, (ros::WallTime::now() - update_start).toSec(), period.toSec());
+  }
+  publishStatistics(time, running);
 
   // there are controllers to start/stop
   if (please_switch_)
@@ -99,15 +129,94 @@ void ControllerManager::update(const ros::Time& time, const ros::Duration& perio
       if (!stop_request_[i]->stopRequest(time))
         ROS_FATAL("Failed to stop controller in realtime loop. This should never happen.");
 
+    // hand state over from replaced controllers
+    for (unsigned int i=0; i<takeover_request_.size(); i++)
+      takeover_request_[i].second->takeOver(*takeover_request_[i].first);
+
     // start controllers
     for (unsigned int i=0; i<start_request_.size(); i++)
       if (!start_request_[i]->startRequest(time))
         ROS_FATAL("Failed to start controller in realtime loop. This should never happen.");
 
+    // update the controllers that are now running from the next cycle on
+    current_running_controllers_ = 1 - current_running_controllers_;
+    ++running_controllers_generation_;
     please_switch_ = false;
   }
 }
 
+// Must be realtime safe.
+void ControllerManager::publishStatistics(const ros::Time& time, const std::vector<RunningController>& running)
+{
+  if (statistics_publish_period_.toSec() <= 0.0)
+    return;
+  const double elapsed = (time - last_statistics_publish_time_).toSec();
+  if (elapsed >= 0.0 && elapsed < statistics_publish_period_.toSec()) // Also publish if time jumped backwards
+    return;
+  if (!pub_controller_stats_.trylock())
+    return;
+
+  // The message is laid out by the non-realtime thread once it is done switching controllers
+  controller_manager_msgs::ControllersStatistics& msg = pub_controller_stats_.msg_;
+  if (statistics_generation_ != running_controllers_generation_ || msg.controller.size() != running.size())
+  {
+    pub_controller_stats_.unlock();
+    return;
+  }
+  last_statistics_publish_time_ = time;
+
+  msg.header.stamp = time;
+  for (size_t i = 0; i < running.size(); ++i)
+  {
+    controller_manager_msgs::ControllerStatistics& cs = msg.controller[i];
+    const ControllerStatistics& stats = *running[i].stats;
+    cs.timestamp                      = time;
+    cs.running                        = running[i].c->isRunning();
+    cs.max_time                       = ros::Duration(stats.max_time);
+    cs.mean_time                      = ros::Duration(stats.mean_time);
+    cs.variance_time                  = ros::Duration(stats.variance_time);
+    cs.num_control_loop_overruns      = stats.num_control_loop_overruns;
+    cs.time_last_control_loop_overrun = stats.time_last_control_loop_overrun;
+
+    const controller_interface::RealtimeArena* arena = running[i].c->getArena();
+    cs.arena_capacity        = arena ? arena->getCapacity() : 0;
+    cs.arena_used            = arena ? arena->getUsed() : 0;
+    cs.arena_high_water_mark = arena ? arena->getHighWaterMark() : 0;
+
+    const controller_interface::ControllerWorkerBase* worker = running[i].c->getWorker();
+    cs.worker_num_requests = worker ? worker->getNumRequests() : 0;
+    cs.worker_max_time     = ros::Duration(worker ? worker->getMaxComputeTime() : 0.0);
+    cs.worker_mean_time    = ros::Duration(worker ? worker->getMeanComputeTime() : 0.0);
+  }
+  pub_controller_stats_.unlockAndPublish();
+}
+
+void ControllerManager::layoutStatistics()
+{
+  if (statistics_publish_period_.toSec() <= 0.0)
+    return;
+
+  // Fill in everything that may allocate, so that the realtime thread only writes numbers
+  const std::vector<RunningController> &running = running_controllers_[current_running_controllers_];
+  const std::vector<ControllerSpec> &controllers = controllers_lists_[current_controllers_list_];
+  pub_controller_stats_.lock();
+  std::vector<controller_manager_msgs::ControllerStatistics>& stats = pub_controller_stats_.msg_.controller;
+  stats.resize(running.size());
+  for (size_t i = 0; i < running.size(); ++i)
+  {
+    for (size_t j = 0; j < controllers.size(); ++j)
+    {
+      if (controllers[j].c.get() == running[i].c)
+      {
+        stats[i].name = controllers[j].info.name;
+        stats[i].type = controllers[j].info.type;
+      }
+    }
+  }
+  statistics_generation_ = running_controllers_generation_;
+  pub_controller_stats_.unlock();
+}
+
 controller_interface::ControllerBase* ControllerManager::getControllerByName(const std::string& name)
 {
   // Lock recursive mutex in this context
@@ -122,52 +231,193 @@ controller_interface::ControllerBase* ControllerManager::getControllerByName(con
   return NULL;
 }
 
-void ControllerManager::getControllerNames(std::vector<std::string> &names)
+void ControllerManager::getControllerStates(const std::vector<ControllerSpec>& controllers,
+                                            std::vector<controller_manager_msgs::ControllerState>& states) const
 {
-  boost::recursive_mutex::scoped_lock guard(controllers_lock_);
-  names.clear();
-  std::vector<ControllerSpec> &controllers = controllers_lists_[current_controllers_list_];
+  states.resize(controllers.size());
   for (size_t i = 0; i < controllers.size(); ++i)
   {
-    names.push_back(controllers[i].info.name);
+    controller_manager_msgs::ControllerState& cs = states[i];
+    cs.name               = controllers[i].info.name;
+    cs.type               = controllers[i].info.type;
+    cs.hardware_interface = controllers[i].info.hardware_interface;
+    cs.resources.clear();
+    cs.resources.reserve(controllers[i].info.resources.size());
+    for (std::set<std::string>::iterator it = controllers[i].info.resources.begin(); it != controllers[i].info.resources.end(); it++)
+      cs.resources.push_back(*it);
+
+    if (controllers[i].c->isRunning())
+      cs.state = "running";
+    else
+      cs.state = "stopped";
   }
 }
 
+void ControllerManager::publishControllerStates()
+{
+  boost::recursive_mutex::scoped_lock guard(controllers_lock_);
+  layoutStatistics();
+
+  boost::shared_ptr<controller_manager_msgs::ControllerStates> states(new controller_manager_msgs::ControllerStates);
+  getControllerStates(controllers_lists_[current_controllers_list_], states->controller);
+
+  // Only publish actual changes. Replaced controllers may change anything but their name
+  const controller_manager_msgs::ControllerStates& previous = *controller_states_;
+  bool changed = (states->controller.size() != previous.controller.size());
+  for (size_t i = 0; i < states->controller.size() && !changed; ++i)
+    changed = (states->controller[i].name               != previous.controller[i].name ||
+               states->controller[i].state              != previous.controller[i].state ||
+               states->controller[i].type               != previous.controller[i].type ||
+               states->controller[i].hardware_interface != previous.controller[i].hardware_interface ||
+               states->controller[i].resources          != previous.controller[i].resources);
+  if (!changed)
+    return;
+
+  states->header.stamp = ros::Time::now();
+  states->generation = previous.generation + 1;
+  boost::atomic_store(&controller_states_, boost::shared_ptr<const controller_manager_msgs::ControllerStates>(states));
+  pub_controller_states_.publish(*states);
+}
 
-bool ControllerManager::loadController(const std::string& name)
+void ControllerManager::updateControllerTypes()
 {
-  ROS_DEBUG("Will load controller '%s'", name.c_str());
+  boost::shared_ptr<controller_manager_msgs::ListControllerTypes::Response> types(
+    new controller_manager_msgs::ListControllerTypes::Response);
+  for(std::list<LoaderPtr>::iterator it = controller_loaders_.begin(); it != controller_loaders_.end(); ++it)
+  {
+    std::vector<std::string> cur_types = (*it)->getDeclaredClasses();
+    for(size_t i=0; i < cur_types.size(); i++)
+    {
+      types->types.push_back(cur_types[i]);
+      types->base_classes.push_back((*it)->getName());
+    }
+  }
+  boost::atomic_store(&controller_types_,
+                      boost::shared_ptr<const controller_manager_msgs::ListControllerTypes::Response>(types));
+}
 
-  // lock controllers
-  boost::recursive_mutex::scoped_lock guard(controllers_lock_);
+bool ControllerManager::claimsExportsOf(const ControllerSpec& claimer, const std::string& exporter) const
+{
+  if (claimer.info.name == exporter)
+    return false;
+  const std::set<std::string>& resources = claimer.info.resources;
+  for (std::set<std::string>::const_iterator it = resources.begin(); it != resources.end(); ++it)
+  {
+    if (virtual_hw_.getExporter(*it) == exporter)
+      return true;
+  }
+  return false;
+}
 
-  // get reference to controller list
-  int free_controllers_list = (current_controllers_list_ + 1) % 2;
-  while (ros::ok() && free_controllers_list == used_by_realtime_){
-    if (!ros::ok())
-      return false;
-    usleep(200);
+bool ControllerManager::getControllerServices(const std::string& name, std::vector<std::string>& services) const
+{
+  services.clear();
+  const std::string ns = ros::NodeHandle(root_nh_, name).getNamespace() + "/";
+
+  XmlRpc::XmlRpcValue args, result, payload;
+  args[0] = ros::this_node::getName();
+  if (!ros::master::execute("getSystemState", args, result, payload, true) ||
+      payload.getType() != XmlRpc::XmlRpcValue::TypeArray || payload.size() < 3)
+    return false;
+
+  // The payload lists publishers, subscribers and services, each as pairs of a name and its providers
+  XmlRpc::XmlRpcValue& service_list = payload[2];
+  for (int i = 0; i < service_list.size(); ++i)
+  {
+    const std::string service = service_list[i][0];
+    if (service.compare(0, ns.size(), ns) != 0)
+      continue;
+    XmlRpc::XmlRpcValue& providers = service_list[i][1];
+    for (int j = 0; j < providers.size(); ++j)
+    {
+      const std::string provider = providers[j];
+      if (provider == ros::this_node::getName())
+        services.push_back(service);
+    }
   }
-  std::vector<ControllerSpec>
-    &from = controllers_lists_[current_controllers_list_],
-    &to = controllers_lists_[free_controllers_list];
-  to.clear();
+  return true;
+}
 
-  // Copy all controllers from the 'from' list to the 'to' list
-  for (size_t i = 0; i < from.size(); ++i)
-    to.push_back(from[i]);
+void ControllerManager::orderCascade(std::vector<ControllerSpec>& controllers) const
+{
+  // Controllers are updated before the controllers whose exported resources they claim, so that a cascade runs
+  // within one cycle. Otherwise they keep their order. Since a controller can only claim resources exported by
+  // controllers loaded before it, there are no cycles.
+  const size_t n = controllers.size();
+  std::map<std::string, size_t> indices;
+  for (size_t i = 0; i < n; ++i)
+    indices[controllers[i].info.name] = i;
+
+  // Edges from each controller to the exporters whose resources it claims, and number of claimers of each exporter
+  std::vector<std::vector<size_t> > exporters(n);
+  std::vector<size_t> num_claimers(n, 0);
+  for (size_t i = 0; i < n; ++i)
+  {
+    const std::set<std::string>& resources = controllers[i].info.resources;
+    for (std::set<std::string>::const_iterator it = resources.begin(); it != resources.end(); ++it)
+    {
+      std::map<std::string, size_t>::const_iterator exporter = indices.find(virtual_hw_.getExporter(*it));
+      if (exporter == indices.end() || exporter->second == i ||
+          std::find(exporters[i].begin(), exporters[i].end(), exporter->second) != exporters[i].end())
+        continue;
+      exporters[i].push_back(exporter->second);
+      ++num_claimers[exporter->second];
+    }
+  }
 
-  // Checks that we're not duplicating controllers
-  for (size_t j = 0; j < to.size(); ++j)
+  // Repeatedly takes the first controller that no pending controller claims resources from
+  std::set<size_t> pending, unclaimed;
+  for (size_t i = 0; i < n; ++i)
   {
-    if (to[j].info.name == name)
+    pending.insert(i);
+    if (num_claimers[i] == 0)
+      unclaimed.insert(i);
+  }
+  std::vector<size_t> order;
+  order.reserve(n);
+  while (!pending.empty())
+  {
+    size_t next;
+    if (unclaimed.empty())
     {
-      to.clear();
-      ROS_ERROR("A controller named '%s' was already loaded inside the controller manager", name.c_str());
-      return false;
+      ROS_ERROR("Controllers claim each others' exported resources, they will not all run within one cycle");
+      next = *pending.begin();
+    }
+    else
+    {
+      next = *unclaimed.begin();
+      unclaimed.erase(unclaimed.begin());
+    }
+    pending.erase(next);
+    order.push_back(next);
+    for (size_t j = 0; j < exporters[next].size(); ++j)
+    {
+      const size_t exporter = exporters[next][j];
+      if (--num_claimers[exporter] == 0 && pending.count(exporter))
+        unclaimed.insert(exporter);
     }
   }
 
+  std::vector<ControllerSpec> ordered(n);
+  for (size_t i = 0; i < n; ++i)
+    swap(ordered[i], controllers[order[i]]);
+  controllers.swap(ordered);
+}
+
+void ControllerManager::getControllerNames(std::vector<std::string> &names)
+{
+  boost::recursive_mutex::scoped_lock guard(controllers_lock_);
+  names.clear();
+  std::vector<ControllerSpec> &controllers = controllers_lists_[current_controllers_list_];
+  for (size_t i = 0; i < controllers.size(); ++i)
+  {
+    names.push_back(controllers[i].info.name);
+  }
+}
+
+
+bool ControllerManager::initController(const std::string& name, ControllerSpec& spec)
+{
   ros::NodeHandle c_nh;
   // Constructs the controller
   try{
@@ -209,7 +459,6 @@ bool ControllerManager::loadController(const std::string& name)
   else
   {
     ROS_ERROR("Could not load controller '%s' because the type was not specified. Did you load the controller configuration on the parameter server (namespace: '%s')?", name.c_str(), c_nh.getNamespace().c_str());
-    to.clear();
     return false;
   }
 
@@ -218,7 +467,6 @@ bool ControllerManager::loadController(const std::string& name)
   {
     ROS_ERROR("Could not load controller '%s' because controller type '%s' does not exist.",  name.c_str(), type.c_str());
     ROS_ERROR("Use 'rosservice call controller_manager/list_controller_types' to get the available types");
-    to.clear();
     return false;
   }
 
@@ -227,7 +475,7 @@ bool ControllerManager::loadController(const std::string& name)
   bool initialized;
   std::set<std::string> claimed_resources; // Gets populated during initRequest call
   try{
-    initialized = c->initRequest(robot_hw_, root_nh_, c_nh, claimed_resources);
+    initialized = c->initRequest(&virtual_hw_, root_nh_, c_nh, claimed_resources);
   }
   catch(std::exception &e){
     ROS_ERROR("Exception thrown while initializing controller %s.\n%s", name.c_str(), e.what());
@@ -239,19 +487,75 @@ bool ControllerManager::loadController(const std::string& name)
   }
   if (!initialized)
   {
-    to.clear();
     ROS_ERROR("Initializing controller '%s' failed", name.c_str());
     return false;
   }
   ROS_DEBUG("Initialized controller '%s' succesful", name.c_str());
 
+  spec.info.type = type;
+  spec.info.hardware_interface = c->getHardwareInterfaceType();
+  spec.info.name = name;
+  spec.info.resources = claimed_resources;
+  spec.c = c;
+  spec.stats.reset(new ControllerStatistics);
+  return true;
+}
+
+
+bool ControllerManager::loadController(const std::string& name)
+{
+  ROS_DEBUG("Will load controller '%s'", name.c_str());
+
+  // lock controllers
+  boost::recursive_mutex::scoped_lock guard(controllers_lock_);
+
+  // get reference to controller list
+  int free_controllers_list = (current_controllers_list_ + 1) % 2;
+  while (ros::ok() && free_controllers_list == used_by_realtime_){
+    if (!ros::ok())
+      return false;
+    usleep(200);
+  }
+  std::vector<ControllerSpec>
+    &from = controllers_lists_[current_controllers_list_],
+    &to = controllers_lists_[free_controllers_list];
+  to.clear();
+
+  // Copy all controllers from the 'from' list to the 'to' list
+  for (size_t i = 0; i < from.size(); ++i)
+    to.push_back(from[i]);
+
+  // Checks that we're not duplicating controllers
+  for (size_t j = 0; j < to.size(); ++j)
+  {
+    if (to[j].info.name == name)
+    {
+      to.clear();
+      ROS_ERROR("A controller named '%s' was already loaded inside the controller manager", name.c_str());
+      return false;
+    }
+  }
+
+  // Constructs and initializes the controller
+  ControllerSpec spec;
+  if (!initController(name, spec))
+  {
+    to.clear();
+    return false;
+  }
+
+  // Makes the interfaces exported by the controller available to the controllers loaded after it
+  if (!virtual_hw_.addExports(name, spec.c->getExportedInterfaces(), spec.info.resources))
+  {
+    to.clear();
+    ROS_ERROR("Could not load controller '%s' because the interfaces it exports clash with existing resources",
+              name.c_str());
+    return false;
+  }
+
   // Adds the controller to the new list
-  to.resize(to.size() + 1);
-  to[to.size()-1].info.type = type;
-  to[to.size()-1].info.hardware_interface = c->getHardwareInterfaceType();
-  to[to.size()-1].info.name = name;
-  to[to.size()-1].info.resources = claimed_resources;
-  to[to.size()-1].c = c;
+  to.push_back(spec);
+  orderCascade(to);
 
   // Destroys the old controllers list when the realtime thread is finished with it.
   int former_current_controllers_list_ = current_controllers_list_;
@@ -262,6 +566,7 @@ bool ControllerManager::loadController(const std::string& name)
     usleep(200);
   }
   from.clear();
+  publishControllerStates();
 
   ROS_DEBUG("Successfully load controller '%s'", name.c_str());
   return true;
@@ -303,7 +608,15 @@ bool ControllerManager::unloadController(const std::string &name)
       removed = true;
     }
     else
+    {
+      if (claimsExportsOf(from[i], name)){
+        to.clear();
+        ROS_ERROR("Could not unload controller with name %s because controller %s claims resources it exports",
+                  name.c_str(), from[i].info.name.c_str());
+        return false;
+      }
       to.push_back(from[i]);
+    }
   }
 
   // Fails if we could not remove the controllers
@@ -324,9 +637,16 @@ bool ControllerManager::unloadController(const std::string &name)
       return false;
     usleep(200);
   }
-  ROS_DEBUG("Destruct controller");
+  virtual_hw_.removeExports(name);
+  ROS_DEBUG("Retire controller");
+  for (size_t i = 0; i < from.size(); ++i)
+  {
+    if (from[i].info.name == name)
+      reaper_.retire(from[i].c);
+  }
   from.clear();
-  ROS_DEBUG("Destruct controller finished");
+  ROS_DEBUG("Retire controller finished");
+  publishControllerStates();
 
   ROS_DEBUG("Successfully unloaded controller '%s'", name.c_str());
   return true;
@@ -334,6 +654,303 @@ bool ControllerManager::unloadController(const std::string &name)
 
 
 
+bool ControllerManager::replaceController(const std::string& name)
+{
+  ROS_DEBUG("Will replace controller '%s'", name.c_str());
+
+  // lock controllers
+  boost::recursive_mutex::scoped_lock guard(controllers_lock_);
+
+  if (!stop_request_.empty() || !start_request_.empty())
+    ROS_FATAL("The switch controller stop and start list are not empty at the beginning of the replaceController call. This should not happen.");
+
+  // find the controller to replace
+  std::vector<ControllerSpec> &from = controllers_lists_[current_controllers_list_];
+  size_t index = 0;
+  while (index < from.size() && from[index].info.name != name)
+    ++index;
+  if (index == from.size())
+  {
+    ROS_ERROR("Could not replace controller with name %s because no controller with this name exists", name.c_str());
+    return false;
+  }
+  ControllerSpec predecessor = from[index];
+
+  // Other controllers would keep using the resources exported by the old instance
+  for (size_t i = 0; i < from.size(); ++i)
+  {
+    if (claimsExportsOf(from[i], name)){
+      ROS_ERROR("Could not replace controller with name %s because controller %s claims resources it exports",
+                name.c_str(), from[i].info.name.c_str());
+      return false;
+    }
+  }
+
+  // A node can advertise a service only once, so the new instance could not advertise the services of the old one
+  std::vector<std::string> services;
+  if (!getControllerServices(name, services))
+  {
+    ROS_ERROR("Could not replace controller with name %s because the services it advertises could not be looked up",
+              name.c_str());
+    return false;
+  }
+  if (!services.empty())
+  {
+    ROS_ERROR("Could not replace controller with name %s because it advertises service %s, which its new instance "
+              "could not advertise while the old one is loaded", name.c_str(), services.front().c_str());
+    return false;
+  }
+
+  // Loads the new instance while the old one keeps running. The new one exports the resources of the old one
+  const bool running = predecessor.c->isRunning();
+  virtual_hw_.removeExports(name);
+  ControllerSpec successor;
+  if (!initController(name, successor) ||
+      !virtual_hw_.addExports(name, successor.c->getExportedInterfaces(), successor.info.resources) ||
+      (running && !prepareReplacement(from, index, successor)))
+  {
+    ROS_ERROR("Could not replace controller with name %s because its new instance could not be loaded", name.c_str());
+    virtual_hw_.removeExports(name);
+    if (!virtual_hw_.addExports(name, predecessor.c->getExportedInterfaces(), predecessor.info.resources))
+      ROS_ERROR("Could not restore the interfaces exported by controller %s, controllers loaded from now on will not "
+                "be able to claim them", name.c_str());
+
+    // The new instance never ran, but destroying it may still take a while
+    reaper_.retire(successor.c);
+    return false;
+  }
+
+  // get reference to controller list
+  int free_controllers_list = (current_controllers_list_ + 1) % 2;
+  while (ros::ok() && free_controllers_list == used_by_realtime_){
+    if (!ros::ok())
+      return false;
+    usleep(200);
+  }
+  std::vector<ControllerSpec> &to = controllers_lists_[free_controllers_list];
+  to = from;
+  to[index] = successor;
+  orderCascade(to);
+
+  // Switches over to the new list. The old instance keeps being updated until it is stopped below
+  int former_current_controllers_list_ = current_controllers_list_;
+  current_controllers_list_ = free_controllers_list;
+  while (ros::ok() && used_by_realtime_ == former_current_controllers_list_){
+    if (!ros::ok())
+      return false;
+    usleep(200);
+  }
+
+  // Stops the old instance and starts the new one in the same realtime cycle
+  if (running)
+  {
+    std::vector<RunningController> &running_next = running_controllers_[1 - current_running_controllers_];
+    running_next.clear();
+    for (size_t i = 0; i < to.size(); ++i)
+    {
+      if (to[i].c->isRunning() || to[i].c == successor.c)
+      {
+        RunningController rc;
+        rc.c = to[i].c.get();
+        rc.stats = to[i].stats.get();
+        running_next.push_back(rc);
+      }
+    }
+    stop_request_.push_back(predecessor.c.get());
+    start_request_.push_back(successor.c.get());
+    takeover_request_.push_back(std::make_pair(predecessor.c.get(), successor.c.get()));
+
+    ROS_DEBUG("Request atomic controller replacement from realtime loop");
+    switch_strictness_ = controller_manager_msgs::SwitchController::Request::STRICT;
+    please_switch_ = true;
+    while (ros::ok() && please_switch_){
+      if (!ros::ok())
+        return false;
+      usleep(100);
+    }
+    try{
+      predecessor.c->cleanupStopRequest();
+    }
+    catch(std::exception &e){
+      ROS_ERROR("Exception thrown while cleaning up the replaced instance of controller %s:\n%s", name.c_str(), e.what());
+    }
+    catch(...){
+      ROS_ERROR("Exception thrown while cleaning up the replaced instance of controller %s", name.c_str());
+    }
+    start_request_.clear();
+    stop_request_.clear();
+    takeover_request_.clear();
+  }
+
+  // Destroys the old instance in the background
+  from.clear();
+  reaper_.retire(predecessor.c);
+  publishControllerStates();
+
+  ROS_DEBUG("Successfully replaced controller '%s'", name.c_str());
+  return true;
+}
+
+bool ControllerManager::reloadControllerType(const std::string& type)
+{
+  ROS_DEBUG("Will reload the library of controller type '%s'", type.c_str());
+
+  // lock controllers
+  boost::recursive_mutex::scoped_lock guard(controllers_lock_);
+
+  // find the loader of the type
+  LoaderPtr loader;
+  for (std::list<LoaderPtr>::iterator it = controller_loaders_.begin();
+       !loader && it != controller_loaders_.end(); ++it)
+  {
+    std::vector<std::string> cur_types = (*it)->getDeclaredClasses();
+    if (std::find(cur_types.begin(), cur_types.end(), type) != cur_types.end())
+      loader = *it;
+  }
+  if (!loader)
+  {
+    ROS_ERROR("Could not reload controller type %s because it does not exist", type.c_str());
+    return false;
+  }
+  const std::vector<std::string> types = loader->getLibraryClasses(type);
+
+  // list the controllers of the library, in update order, and the running ones
+  std::vector<std::string> names, running;
+  std::vector<ControllerSpec> &controllers = controllers_lists_[current_controllers_list_];
+  for (size_t i = 0; i < controllers.size(); ++i)
+  {
+    if (std::find(types.begin(), types.end(), controllers[i].info.type) == types.end())
+      continue;
+    names.push_back(controllers[i].info.name);
+    if (controllers[i].c->isRunning())
+      running.push_back(controllers[i].info.name);
+  }
+
+  // Controllers of other libraries would keep using the resources exported by the unloaded ones
+  for (size_t i = 0; i < controllers.size(); ++i)
+  {
+    if (std::find(names.begin(), names.end(), controllers[i].info.name) != names.end())
+      continue;
+    for (size_t j = 0; j < names.size(); ++j)
+    {
+      if (claimsExportsOf(controllers[i], names[j])){
+        ROS_ERROR("Could not reload controller type %s because controller %s claims resources exported by %s",
+                  type.c_str(), controllers[i].info.name.c_str(), names[j].c_str());
+        return false;
+      }
+    }
+  }
+
+  // Drains the controllers of the library. Claimers come before exporters in update order, so they are unloaded first
+  const int strict = controller_manager_msgs::SwitchController::Request::STRICT;
+  if (!running.empty() && !switchController(std::vector<std::string>(), running, strict))
+  {
+    ROS_ERROR("Could not reload controller type %s because its controllers could not be stopped", type.c_str());
+    return false;
+  }
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    if (!unloadController(names[i])){
+      ROS_ERROR("Could not reload controller type %s because controller %s could not be unloaded",
+                type.c_str(), names[i].c_str());
+      restoreControllers(names, running);
+      return false;
+    }
+  }
+
+  // Controllers must be destroyed before their library is unloaded
+  reaper_.drain();
+  bool ok = loader->reloadLibrary(type);
+  if (ok)
+    ROS_INFO("Controller manager: reloaded the controller library of %s", type.c_str());
+  else
+    ROS_ERROR("Controller manager: could not reload the controller library of %s", type.c_str());
+  updateControllerTypes();
+
+  return restoreControllers(names, running) && ok;
+}
+
+bool ControllerManager::restoreControllers(const std::vector<std::string>& names,
+                                           const std::vector<std::string>& running)
+{
+  // Loads the controllers that are missing, exporters first
+  bool ok = true;
+  for (size_t i = names.size(); i > 0; --i)
+  {
+    if (!getControllerByName(names[i-1]) && !loadController(names[i-1])){
+      ROS_ERROR("Could not load controller %s again", names[i-1].c_str());
+      ok = false;
+    }
+  }
+
+  // Restarts the ones that were running, in one cycle
+  std::vector<std::string> restart;
+  for (size_t i = 0; i < running.size(); ++i)
+  {
+    if (getControllerByName(running[i]))
+      restart.push_back(running[i]);
+  }
+  const int strict = controller_manager_msgs::SwitchController::Request::STRICT;
+  if (!restart.empty() && !switchController(restart, std::vector<std::string>(), strict))
+  {
+    ROS_ERROR("Could not restart controllers after loading them again");
+    ok = false;
+  }
+  return ok && restart.size() == running.size();
+}
+
+bool ControllerManager::prepareReplacement(const std::vector<ControllerSpec>& controllers, size_t index,
+                                           const ControllerSpec& successor)
+{
+  // The new instance runs along with the running controllers, except the old instance
+  std::list<hardware_interface::ControllerInfo> info_list;
+  for (size_t i = 0; i < controllers.size(); ++i)
+  {
+    if (i != index && controllers[i].c->isRunning())
+      info_list.push_back(controllers[i].info);
+  }
+  info_list.push_back(successor.info);
+  if (virtual_hw_.checkForConflict(info_list))
+  {
+    ROS_ERROR("Could not replace controller %s, due to resource conflict", successor.info.name.c_str());
+    return false;
+  }
+
+  // Controllers claiming resources exported by other controllers can only run along with them
+  for (std::set<std::string>::const_iterator resource_it = successor.info.resources.begin();
+       resource_it != successor.info.resources.end(); ++resource_it)
+  {
+    const std::string exporter = virtual_hw_.getExporter(*resource_it);
+    bool exporter_running = exporter.empty();
+    for (std::list<hardware_interface::ControllerInfo>::const_iterator it = info_list.begin();
+         it != info_list.end(); ++it)
+      exporter_running = exporter_running || (it->name == exporter);
+    if (!exporter_running)
+    {
+      ROS_ERROR("Could not replace controller %s, because it claims resource %s, which is exported by controller %s "
+                "that is not running", successor.info.name.c_str(), resource_it->c_str(), exporter.c_str());
+      return false;
+    }
+  }
+
+  bool prepared = false;
+  try{
+    prepared = successor.c->prepareStartRequest();
+  }
+  catch(std::exception &e){
+    ROS_ERROR("Exception thrown while preparing to start controller %s:\n%s", successor.info.name.c_str(), e.what());
+  }
+  catch(...){
+    ROS_ERROR("Exception thrown while preparing to start controller %s", successor.info.name.c_str());
+  }
+  if (!prepared)
+    ROS_ERROR("Could not replace controller %s, because its new instance failed to prepare to start",
+              successor.info.name.c_str());
+  return prepared;
+}
+
+
+
 bool ControllerManager::switchController(const std::vector<std::string>& start_controllers,
                                          const std::vector<std::string>& stop_controllers,
                                          int strictness)
@@ -407,9 +1024,47 @@ bool ControllerManager::switchController(const std::vector<std::string>& start_c
   }
   ROS_DEBUG("Start request vector has size %i", (int)start_request_.size());
 
-  // Do the resource management checking
-  std::list<hardware_interface::ControllerInfo> info_list;
+  // Do the non-realtime part of starting controllers before arming the switch, so that the realtime thread
+  // only has their bounded starting() left to call
   std::vector<ControllerSpec> &controllers = controllers_lists_[current_controllers_list_];
+  for (size_t i = 0; i < start_request_.size();)
+  {
+    bool prepared = false;
+    try{
+      prepared = start_request_[i]->prepareStartRequest();
+    }
+    catch(std::exception &e){
+      ROS_ERROR("Exception thrown while preparing to start a controller:\n%s", e.what());
+    }
+    catch(...){
+      ROS_ERROR("Exception thrown while preparing to start a controller");
+    }
+    if (prepared)
+    {
+      ++i;
+      continue;
+    }
+
+    std::string name;
+    for (size_t j = 0; j < controllers.size(); ++j)
+      if (controllers[j].c.get() == start_request_[i])
+        name = controllers[j].info.name;
+    if (strictness ==  controller_manager_msgs::SwitchController::Request::STRICT){
+      ROS_ERROR("Could not switch controllers, because controller %s failed to prepare to start", name.c_str());
+      start_request_.resize(i);
+      cleanupStopRequests(start_request_);
+      stop_request_.clear();
+      start_request_.clear();
+      return false;
+    }
+    ROS_ERROR("Could not start controller %s because it failed to prepare to start", name.c_str());
+    start_request_.erase(start_request_.begin() + i);
+  }
+
+  // Do the resource management checking, and list the controllers that will be running, in update order
+  std::list<hardware_interface::ControllerInfo> info_list;
+  std::vector<RunningController> &running = running_controllers_[1 - current_running_controllers_];
+  running.clear();
   for (size_t i = 0; i < controllers.size(); ++i)
   {
     bool in_stop_list  = false;
@@ -428,18 +1083,52 @@ bool ControllerManager::switchController(const std::vector<std::string>& start_c
       add_to_list = true;
 
     if (add_to_list)
+    {
       info_list.push_back(controllers[i].info);
+      RunningController rc;
+      rc.c = controllers[i].c.get();
+      rc.stats = controllers[i].stats.get();
+      running.push_back(rc);
+    }
   }
 
   bool in_conflict = robot_hw_->checkForConflict(info_list);
   if (in_conflict)
   {
     ROS_ERROR("Could not switch controllers, due to resource conflict");
+    cleanupStopRequests(start_request_);
     stop_request_.clear();
     start_request_.clear();
     return false;
   }
 
+  // Controllers claiming resources exported by other controllers can only run along with them
+  for (std::list<hardware_interface::ControllerInfo>::const_iterator info_it = info_list.begin();
+       info_it != info_list.end(); ++info_it)
+  {
+    for (std::set<std::string>::const_iterator resource_it = info_it->resources.begin();
+         resource_it != info_it->resources.end(); ++resource_it)
+    {
+      const std::string exporter = virtual_hw_.getExporter(*resource_it);
+      if (exporter.empty())
+        continue;
+      bool exporter_running = false;
+      for (std::list<hardware_interface::ControllerInfo>::const_iterator it = info_list.begin();
+           it != info_list.end(); ++it)
+        exporter_running = exporter_running || (it->name == exporter);
+      if (!exporter_running)
+      {
+        ROS_ERROR("Could not switch controllers, because controller %s claims resource %s, which is exported by "
+                  "controller %s that would not be running", info_it->name.c_str(), resource_it->c_str(),
+                  exporter.c_str());
+        cleanupStopRequests(start_request_);
+        stop_request_.clear();
+        start_request_.clear();
+        return false;
+      }
+    }
+  }
+
   // start the atomic controller switching
   switch_strictness_ = strictness;
   please_switch_ = true;
@@ -451,8 +1140,13 @@ bool ControllerManager::switchController(const std::vector<std::string>& start_c
       return false;
     usleep(100);
   }
+
+  // Do the non-realtime part of stopping controllers
+  cleanupStopRequests(stop_request_);
+
   start_request_.clear();
   stop_request_.clear();
+  publishControllerStates();
 
   ROS_DEBUG("Successfully switched controllers");
   return true;
@@ -462,6 +1156,23 @@ bool ControllerManager::switchController(const std::vector<std::string>& start_c
 
 
 
+void ControllerManager::cleanupStopRequests(const std::vector<controller_interface::ControllerBase*>& controllers)
+{
+  for (size_t i = 0; i < controllers.size(); ++i)
+  {
+    try{
+      controllers[i]->cleanupStopRequest();
+    }
+    catch(std::exception &e){
+      ROS_ERROR("Exception thrown while cleaning up a stopped controller:\n%s", e.what());
+    }
+    catch(...){
+      ROS_ERROR("Exception thrown while cleaning up a stopped controller");
+    }
+  }
+}
+
+
 bool ControllerManager::reloadControllerLibrariesSrv(
   controller_manager_msgs::ReloadControllerLibraries::Request &req,
   controller_manager_msgs::ReloadControllerLibraries::Response &resp)
@@ -501,12 +1212,16 @@ bool ControllerManager::reloadControllerLibrariesSrv(
   }
   assert(controllers.empty());
 
+  // Controllers must be destroyed before their libraries are unloaded
+  reaper_.drain();
+
   // Force a reload on all the PluginLoaders (internally, this recreates the plugin loaders)
   for(std::list<LoaderPtr>::iterator it = controller_loaders_.begin(); it != controller_loaders_.end(); ++it)
   {
     (*it)->reload();
     ROS_INFO("Controller manager: reloaded controller libraries for %s", (*it)->getName().c_str());
   }
+  updateControllerTypes();
 
   resp.ok = true;
 
@@ -515,6 +1230,22 @@ bool ControllerManager::reloadControllerLibrariesSrv(
 }
 
 
+bool ControllerManager::reloadControllerTypeSrv(
+  controller_manager_msgs::ReloadControllerType::Request &req,
+  controller_manager_msgs::ReloadControllerType::Response &resp)
+{
+  // lock services
+  ROS_DEBUG("reload type service called for controller type %s ", req.type.c_str());
+  boost::mutex::scoped_lock guard(services_lock_);
+  ROS_DEBUG("reload type service locked");
+
+  resp.ok = reloadControllerType(req.type);
+
+  ROS_DEBUG("reload type service finished for controller type %s ", req.type.c_str());
+  return true;
+}
+
+
 bool ControllerManager::listControllerTypesSrv(
   controller_manager_msgs::ListControllerTypes::Request &req,
   controller_manager_msgs::ListControllerTypes::Response &resp)
@@ -522,20 +1253,9 @@ bool ControllerManager::listControllerTypesSrv(
   // pretend to use the request
   (void) req;
 
-  // lock services
+  // answer from the snapshot, without waiting for other services
   ROS_DEBUG("list types service called");
-  boost::mutex::scoped_lock guard(services_lock_);
-  ROS_DEBUG("list types service locked");
-
-  for(std::list<LoaderPtr>::iterator it = controller_loaders_.begin(); it != controller_loaders_.end(); ++it)
-  {
-    std::vector<std::string> cur_types = (*it)->getDeclaredClasses();
-    for(size_t i=0; i < cur_types.size(); i++)
-    {
-      resp.types.push_back(cur_types[i]);
-      resp.base_classes.push_back((*it)->getName());
-    }
-  }
+  resp = *boost::atomic_load(&controller_types_);
 
   ROS_DEBUG("list types service finished");
   return true;
@@ -549,32 +1269,9 @@ bool ControllerManager::listControllersSrv(
   // pretend to use the request
   (void) req;
 
-  // lock services
+  // answer from the snapshot, without waiting for other services
   ROS_DEBUG("list controller service called");
-  boost::mutex::scoped_lock services_guard(services_lock_);
-  ROS_DEBUG("list controller service locked");
-
-  // lock controllers to get all names/types/states
-  boost::recursive_mutex::scoped_lock controller_guard(controllers_lock_);
-  std::vector<ControllerSpec> &controllers = controllers_lists_[current_controllers_list_];
-  resp.controller.resize(controllers.size());
-
-  for (size_t i = 0; i < controllers.size(); ++i)
-  {
-    controller_manager_msgs::ControllerState& cs = resp.controller[i];
-    cs.name               = controllers[i].info.name;
-    cs.type               = controllers[i].info.type;
-    cs.hardware_interface = controllers[i].info.hardware_interface;
-    cs.resources.clear();
-    cs.resources.reserve(controllers[i].info.resources.size());
-    for (std::set<std::string>::iterator it = controllers[i].info.resources.begin(); it != controllers[i].info.resources.end(); it++)
-      cs.resources.push_back(*it);
-
-    if (controllers[i].c->isRunning())
-      cs.state = "running";
-    else
-      cs.state = "stopped";
-  }
+  resp.controller = boost::atomic_load(&controller_states_)->controller;
 
   ROS_DEBUG("list controller service finished");
   return true;
@@ -613,6 +1310,22 @@ bool ControllerManager::unloadControllerSrv(
 }
 
 
+bool ControllerManager::replaceControllerSrv(
+  controller_manager_msgs::ReplaceController::Request &req,
+  controller_manager_msgs::ReplaceController::Response &resp)
+{
+  // lock services
+  ROS_DEBUG("replacing service called for controller %s ",req.name.c_str());
+  boost::mutex::scoped_lock guard(services_lock_);
+  ROS_DEBUG("replacing service locked");
+
+  resp.ok = replaceController(req.name);
+
+  ROS_DEBUG("replacing service finished for controller %s ",req.name.c_str());
+  return true;
+}
+
+
 bool ControllerManager::switchControllerSrv(
   controller_manager_msgs::SwitchController::Request &req,
   controller_manager_msgs::SwitchController::Response &resp)
@@ -631,6 +1344,7 @@ bool ControllerManager::switchControllerSrv(
 void ControllerManager::registerControllerLoader(boost::shared_ptr<ControllerLoaderInterface> controller_loader)
 {
   controller_loaders_.push_back(controller_loader);
+  updateControllerTypes();
 }
 
 }
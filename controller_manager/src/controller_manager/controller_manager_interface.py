@@ -49,6 +49,18 @@ def reload_libraries(force_kill, restore = False):
     return result
 
 
+def reload_controller_type(controller_type):
+    rospy.wait_for_service('controller_manager/reload_controller_type')
+    s = rospy.ServiceProxy('controller_manager/reload_controller_type', ReloadControllerType)
+    resp = s.call(ReloadControllerTypeRequest(controller_type))
+    if resp.ok:
+        print "Successfully reloaded the library of %s" % controller_type
+        return True
+    else:
+        print "Error when reloading the library of", controller_type
+        return False
+
+
 def list_controllers():
     rospy.wait_for_service('controller_manager/list_controllers')
     s = rospy.ServiceProxy('controller_manager/list_controllers', ListControllers)
@@ -82,6 +94,17 @@ def unload_controller(name):
         print "Error when unloading", name
         return False
 
+def replace_controller(name):
+    rospy.wait_for_service('controller_manager/replace_controller')
+    s = rospy.ServiceProxy('controller_manager/replace_controller', ReplaceController)
+    resp = s.call(ReplaceControllerRequest(name))
+    if resp.ok == 1:
+        print "Replaced %s successfully" % name
+        return True
+    else:
+        print "Error when replacing", name
+        return False
+
 def start_controller(name):
     return start_stop_controllers([name], True)
 
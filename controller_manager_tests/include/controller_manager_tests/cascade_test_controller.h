@@ -0,0 +1,80 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2012, hiDOF INC.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of hiDOF, Inc. nor the names of its
+//     contributors may be used to endorse or promote products derived from
+//     this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef CONTROLLER_MANAGER_TESTS_CASCADE_TEST_CONTROLLER_H
+#define CONTROLLER_MANAGER_TESTS_CASCADE_TEST_CONTROLLER_H
+
+
+#include <controller_interface/controller.h>
+#include <hardware_interface/joint_command_interface.h>
+#include <std_srvs/Empty.h>
+#include <pluginlib/class_list_macros.h>
+
+
+namespace controller_manager_tests
+{
+
+
+/** Velocity controller of one joint, which can export a velocity-commanded
+ *  virtual joint for another controller to command it through. Its
+ *  non-realtime start and stop hooks record whether it is prepared to run in
+ *  its \c prepared parameter, and can be made to fail with the
+ *  \c fail_prepare_start parameter. It advertises a \c ping service in its
+ *  namespace if its \c advertise_service parameter is set. */
+class CascadeTestController: public controller_interface::Controller<hardware_interface::VelocityJointInterface>
+{
+public:
+  CascadeTestController()
+    : exported_position_(0.0), exported_velocity_(0.0), exported_effort_(0.0), exported_command_(0.0),
+      exporting_(false), fail_prepare_start_(false)
+  {}
+
+  bool init(hardware_interface::VelocityJointInterface* hw, ros::NodeHandle &n);
+  void starting(const ros::Time& time);
+  void update(const ros::Time& time, const ros::Duration& period);
+  void stopping(const ros::Time& time);
+  bool prepareStart();
+  void cleanupStop();
+
+private:
+  ros::NodeHandle nh_;
+  ros::ServiceServer ping_service_;
+
+  hardware_interface::JointHandle joint_;
+
+  hardware_interface::VelocityJointInterface exported_interface_;
+  double exported_position_, exported_velocity_, exported_effort_, exported_command_;
+  bool exporting_;
+  bool fail_prepare_start_;
+
+  bool ping(std_srvs::Empty::Request& req, std_srvs::Empty::Response& resp) {return true;}
+};
+
+}
+
+#endif
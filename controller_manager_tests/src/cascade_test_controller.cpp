@@ -0,0 +1,101 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2012, hiDOF INC.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of hiDOF Inc nor the names of its
+//     contributors may be used to endorse or promote products derived from
+//     this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//////////////////////////////////////////////////////////////////////////////
+
+
+#include <controller_manager_tests/cascade_test_controller.h>
+
+using namespace controller_manager_tests;
+
+bool CascadeTestController::init(hardware_interface::VelocityJointInterface* hw, ros::NodeHandle &n)
+{
+  std::string joint, exported_joint;
+  if (!n.getParam("joint", joint))
+  {
+    ROS_ERROR("No joint given (namespace: %s)", n.getNamespace().c_str());
+    return false;
+  }
+  joint_ = hw->getHandle(joint);
+  nh_ = n;
+  n.param("fail_prepare_start", fail_prepare_start_, false);
+  n.setParam("prepared", false);
+
+  bool advertise_service = false;
+  n.param("advertise_service", advertise_service, false);
+  if (advertise_service)
+    ping_service_ = n.advertiseService("ping", &CascadeTestController::ping, this);
+
+  // export a virtual joint, whose velocity command is forwarded to the controlled joint
+  exporting_ = n.getParam("exported_joint", exported_joint);
+  if (exporting_)
+  {
+    hardware_interface::JointStateHandle state(exported_joint, &exported_position_, &exported_velocity_,
+                                               &exported_effort_);
+    exported_interface_.registerHandle(hardware_interface::JointHandle(state, &exported_command_));
+    exportInterface(&exported_interface_);
+  }
+
+  return true;
+}
+
+void CascadeTestController::starting(const ros::Time& time)
+{
+  ROS_INFO("Starting CascadeTest Controller");
+  exported_command_ = 0.0;
+}
+
+void CascadeTestController::update(const ros::Time& time, const ros::Duration& period)
+{
+  if (exporting_)
+  {
+    exported_position_ = joint_.getPosition();
+    exported_velocity_ = joint_.getVelocity();
+    exported_effort_   = joint_.getEffort();
+    joint_.setCommand(exported_command_);
+  }
+  else
+    joint_.setCommand(-joint_.getPosition());
+}
+
+void CascadeTestController::stopping(const ros::Time& time)
+{
+  ROS_INFO("Stopping CascadeTest Controller");
+}
+
+bool CascadeTestController::prepareStart()
+{
+  if (fail_prepare_start_)
+    return false;
+  nh_.setParam("prepared", true);
+  return true;
+}
+
+void CascadeTestController::cleanupStop()
+{
+  nh_.setParam("prepared", false);
+}
+
+PLUGINLIB_EXPORT_CLASS( controller_manager_tests::CascadeTestController, controller_interface::ControllerBase)
@@ -0,0 +1,59 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2012, hiDOF INC.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of hiDOF Inc nor the names of its
+//     contributors may be used to endorse or promote products derived from
+//     this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//////////////////////////////////////////////////////////////////////////////
+
+
+#include <controller_manager_tests/multi_interface_test_controller.h>
+
+using namespace controller_manager_tests;
+
+bool MultiInterfaceTestController::init(hardware_interface::RobotHW* robot_hw, ros::NodeHandle &n)
+{
+  // command one joint in effort and the other in velocity, and read the state of both
+  joint_effort_command_   = robot_hw->get<hardware_interface::EffortJointInterface>()->getHandle("hiDOF_joint1");
+  joint_velocity_command_ = robot_hw->get<hardware_interface::VelocityJointInterface>()->getHandle("hiDOF_joint2");
+  joint_state_            = robot_hw->get<hardware_interface::JointStateInterface>()->getHandle("hiDOF_joint2");
+
+  return true;
+}
+
+void MultiInterfaceTestController::starting(const ros::Time& time)
+{
+  ROS_INFO("Starting MultiInterfaceTest Controller");
+}
+
+void MultiInterfaceTestController::update(const ros::Time& time, const ros::Duration& period)
+{
+  joint_effort_command_.setCommand(0.0);
+  joint_velocity_command_.setCommand(-joint_state_.getPosition());
+}
+
+void MultiInterfaceTestController::stopping(const ros::Time& time)
+{
+  ROS_INFO("Stopping MultiInterfaceTest Controller");
+}
+
+PLUGINLIB_EXPORT_CLASS( controller_manager_tests::MultiInterfaceTestController, controller_interface::ControllerBase)
@@ -28,9 +28,16 @@
 //! /author Vijay Pradeep
 
 #include <ros/ros.h>
+#include <ros/topic.h>
 #include <gtest/gtest.h>
 
+#include <controller_manager_msgs/ControllerStates.h>
+#include <controller_manager_msgs/ListControllers.h>
 #include <controller_manager_msgs/LoadController.h>
+#include <controller_manager_msgs/ReloadControllerType.h>
+#include <controller_manager_msgs/ReplaceController.h>
+#include <controller_manager_msgs/SwitchController.h>
+#include <controller_manager_msgs/UnloadController.h>
 
 using namespace controller_manager_msgs;
 
@@ -67,6 +74,238 @@ TEST(CMTests, spawnTestMismatch)
   EXPECT_FALSE(srv.response.ok);
 }
 
+TEST(CMTests, spawnTestMultiInterface)
+{
+  ros::NodeHandle nh;
+  ros::ServiceClient client = nh.serviceClient<LoadController>("/controller_manager/load_controller");
+  LoadController srv;
+  srv.request.name = "multi_interface_controller";
+  bool call_success = client.call(srv);
+  EXPECT_TRUE(call_success);
+  EXPECT_TRUE(srv.response.ok);
+}
+
+TEST(CMTests, spawnTestCascade)
+{
+  ros::NodeHandle nh;
+  ros::ServiceClient client = nh.serviceClient<LoadController>("/controller_manager/load_controller");
+  LoadController srv;
+
+  // the outer controller claims the virtual joint exported by the inner one
+  srv.request.name = "cascade_inner_controller";
+  EXPECT_TRUE(client.call(srv));
+  EXPECT_TRUE(srv.response.ok);
+  srv.request.name = "cascade_outer_controller";
+  EXPECT_TRUE(client.call(srv));
+  EXPECT_TRUE(srv.response.ok);
+
+  // the outer controller is updated first, so that its command reaches the inner one within the same cycle
+  ros::ServiceClient list_client = nh.serviceClient<ListControllers>("/controller_manager/list_controllers");
+  ListControllers list_srv;
+  EXPECT_TRUE(list_client.call(list_srv));
+  int outer_index = -1, inner_index = -1;
+  for (size_t i = 0; i < list_srv.response.controller.size(); ++i)
+  {
+    if (list_srv.response.controller[i].name == "cascade_outer_controller")
+      outer_index = i;
+    if (list_srv.response.controller[i].name == "cascade_inner_controller")
+      inner_index = i;
+  }
+  EXPECT_NE(-1, outer_index);
+  EXPECT_NE(-1, inner_index);
+  EXPECT_LT(outer_index, inner_index);
+
+  // the outer controller can only run along with the inner one
+  ros::ServiceClient switch_client = nh.serviceClient<SwitchController>("/controller_manager/switch_controller");
+  SwitchController switch_srv;
+  switch_srv.request.strictness = SwitchController::Request::STRICT;
+  switch_srv.request.start_controllers.push_back("cascade_outer_controller");
+  EXPECT_TRUE(switch_client.call(switch_srv));
+  EXPECT_FALSE(switch_srv.response.ok);
+  switch_srv.request.start_controllers.push_back("cascade_inner_controller");
+  EXPECT_TRUE(switch_client.call(switch_srv));
+  EXPECT_TRUE(switch_srv.response.ok);
+
+  switch_srv.request.start_controllers.clear();
+  switch_srv.request.stop_controllers.push_back("cascade_inner_controller");
+  EXPECT_TRUE(switch_client.call(switch_srv));
+  EXPECT_FALSE(switch_srv.response.ok);
+  switch_srv.request.stop_controllers.push_back("cascade_outer_controller");
+  EXPECT_TRUE(switch_client.call(switch_srv));
+  EXPECT_TRUE(switch_srv.response.ok);
+
+  // the inner controller can't be unloaded while the outer one uses its virtual joint
+  ros::ServiceClient unload_client = nh.serviceClient<UnloadController>("/controller_manager/unload_controller");
+  UnloadController unload_srv;
+  unload_srv.request.name = "cascade_inner_controller";
+  EXPECT_TRUE(unload_client.call(unload_srv));
+  EXPECT_FALSE(unload_srv.response.ok);
+  unload_srv.request.name = "cascade_outer_controller";
+  EXPECT_TRUE(unload_client.call(unload_srv));
+  EXPECT_TRUE(unload_srv.response.ok);
+  unload_srv.request.name = "cascade_inner_controller";
+  EXPECT_TRUE(unload_client.call(unload_srv));
+  EXPECT_TRUE(unload_srv.response.ok);
+}
+
+TEST(CMTests, controllerStatesTopic)
+{
+  ros::NodeHandle nh;
+  const std::string topic = "/controller_manager/controller_states";
+  ControllerStatesConstPtr before = ros::topic::waitForMessage<ControllerStates>(topic, nh, ros::Duration(5.0));
+  ASSERT_TRUE(before);
+
+  ros::ServiceClient client = nh.serviceClient<LoadController>("/controller_manager/load_controller");
+  LoadController srv;
+  srv.request.name = "my_controller2";
+  EXPECT_TRUE(client.call(srv));
+  EXPECT_TRUE(srv.response.ok);
+
+  // the (latched) states of the controllers are republished with the new controller
+  ControllerStatesConstPtr after = ros::topic::waitForMessage<ControllerStates>(topic, nh, ros::Duration(5.0));
+  ASSERT_TRUE(after);
+  EXPECT_EQ(before->generation + 1, after->generation);
+  EXPECT_EQ(before->controller.size() + 1, after->controller.size());
+  bool found = false;
+  for (size_t i = 0; i < after->controller.size(); ++i)
+  {
+    if (after->controller[i].name == "my_controller2")
+    {
+      found = true;
+      EXPECT_EQ("stopped", after->controller[i].state);
+    }
+  }
+  EXPECT_TRUE(found);
+}
+
+TEST(CMTests, replaceTest)
+{
+  ros::NodeHandle nh;
+  ros::ServiceClient client = nh.serviceClient<ReplaceController>("/controller_manager/replace_controller");
+  ReplaceController srv;
+
+  // my_controller is loaded by spawnTestGood
+  srv.request.name = "my_controller";
+  EXPECT_TRUE(client.call(srv));
+  EXPECT_TRUE(srv.response.ok);
+
+  srv.request.name = "nonexistent_controller";
+  EXPECT_TRUE(client.call(srv));
+  EXPECT_FALSE(srv.response.ok);
+}
+
+TEST(CMTests, replaceServiceTest)
+{
+  ros::NodeHandle nh;
+  ros::ServiceClient load_client = nh.serviceClient<LoadController>("/controller_manager/load_controller");
+  LoadController load_srv;
+  load_srv.request.name = "service_controller";
+  EXPECT_TRUE(load_client.call(load_srv));
+  EXPECT_TRUE(load_srv.response.ok);
+  EXPECT_TRUE(ros::service::waitForService("/service_controller/ping", ros::Duration(5.0)));
+
+  // the new instance could not advertise the service of the old one, which keeps it
+  ros::ServiceClient client = nh.serviceClient<ReplaceController>("/controller_manager/replace_controller");
+  ReplaceController srv;
+  srv.request.name = "service_controller";
+  EXPECT_TRUE(client.call(srv));
+  EXPECT_FALSE(srv.response.ok);
+  EXPECT_TRUE(ros::service::exists("/service_controller/ping", false));
+
+  ros::ServiceClient unload_client = nh.serviceClient<UnloadController>("/controller_manager/unload_controller");
+  UnloadController unload_srv;
+  unload_srv.request.name = "service_controller";
+  EXPECT_TRUE(unload_client.call(unload_srv));
+  EXPECT_TRUE(unload_srv.response.ok);
+}
+
+TEST(CMTests, reloadTypeTest)
+{
+  ros::NodeHandle nh;
+  ros::ServiceClient client = nh.serviceClient<ReloadControllerType>("/controller_manager/reload_controller_type");
+  ReloadControllerType srv;
+
+  // my_controller is loaded by spawnTestGood, and is restored after the reload
+  srv.request.type = "controller_manager_tests/EffortTestController";
+  EXPECT_TRUE(client.call(srv));
+  EXPECT_TRUE(srv.response.ok);
+
+  ros::ServiceClient list_client = nh.serviceClient<ListControllers>("/controller_manager/list_controllers");
+  ListControllers list_srv;
+  EXPECT_TRUE(list_client.call(list_srv));
+  bool found = false;
+  for (size_t i = 0; i < list_srv.response.controller.size(); ++i)
+    found = found || (list_srv.response.controller[i].name == "my_controller");
+  EXPECT_TRUE(found);
+
+  srv.request.type = "nonexistent_type";
+  EXPECT_TRUE(client.call(srv));
+  EXPECT_FALSE(srv.response.ok);
+}
+
+TEST(CMTests, startStopHooksTest)
+{
+  ros::NodeHandle nh;
+  ros::ServiceClient load_client = nh.serviceClient<LoadController>("/controller_manager/load_controller");
+  LoadController load_srv;
+  load_srv.request.name = "hooks_controller";
+  EXPECT_TRUE(load_client.call(load_srv));
+  EXPECT_TRUE(load_srv.response.ok);
+  load_srv.request.name = "hooks_failing_controller";
+  EXPECT_TRUE(load_client.call(load_srv));
+  EXPECT_TRUE(load_srv.response.ok);
+
+  ros::ServiceClient client = nh.serviceClient<SwitchController>("/controller_manager/switch_controller");
+  SwitchController srv;
+  srv.request.start_controllers.push_back("hooks_controller");
+  srv.request.start_controllers.push_back("hooks_failing_controller");
+  bool prepared = true;
+
+  // a strict switch fails, and the controllers prepared before the failing one are cleaned up
+  srv.request.strictness = SwitchController::Request::STRICT;
+  EXPECT_TRUE(client.call(srv));
+  EXPECT_FALSE(srv.response.ok);
+  EXPECT_TRUE(nh.getParam("/hooks_controller/prepared", prepared));
+  EXPECT_FALSE(prepared);
+
+  // a best-effort switch starts the controllers that could be prepared
+  srv.request.strictness = SwitchController::Request::BEST_EFFORT;
+  EXPECT_TRUE(client.call(srv));
+  EXPECT_TRUE(srv.response.ok);
+  EXPECT_TRUE(nh.getParam("/hooks_controller/prepared", prepared));
+  EXPECT_TRUE(prepared);
+
+  ros::ServiceClient list_client = nh.serviceClient<ListControllers>("/controller_manager/list_controllers");
+  ListControllers list_srv;
+  EXPECT_TRUE(list_client.call(list_srv));
+  for (size_t i = 0; i < list_srv.response.controller.size(); ++i)
+  {
+    const ControllerState& cs = list_srv.response.controller[i];
+    if (cs.name == "hooks_controller")
+      EXPECT_EQ("running", cs.state);
+    if (cs.name == "hooks_failing_controller")
+      EXPECT_EQ("stopped", cs.state);
+  }
+
+  // stopping cleans up
+  srv.request.start_controllers.clear();
+  srv.request.stop_controllers.push_back("hooks_controller");
+  srv.request.strictness = SwitchController::Request::STRICT;
+  EXPECT_TRUE(client.call(srv));
+  EXPECT_TRUE(srv.response.ok);
+  EXPECT_TRUE(nh.getParam("/hooks_controller/prepared", prepared));
+  EXPECT_FALSE(prepared);
+
+  ros::ServiceClient unload_client = nh.serviceClient<UnloadController>("/controller_manager/unload_controller");
+  UnloadController unload_srv;
+  unload_srv.request.name = "hooks_controller";
+  EXPECT_TRUE(unload_client.call(unload_srv));
+  EXPECT_TRUE(unload_srv.response.ok);
+  unload_srv.request.name = "hooks_failing_controller";
+  EXPECT_TRUE(unload_client.call(unload_srv));
+  EXPECT_TRUE(unload_srv.response.ok);
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
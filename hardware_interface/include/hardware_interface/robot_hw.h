@@ -132,11 +132,11 @@ public:
   template<class T>
   T* get()
   {
-    InterfaceMap::iterator it = interfaces_.find(internal::demangledTypeName<T>());
-    if (it == interfaces_.end())
+    HardwareInterface* iface = getInterface(internal::demangledTypeName<T>());
+    if (!iface)
       return NULL;
 
-    T* hw = dynamic_cast<T*>(it->second);
+    T* hw = dynamic_cast<T*>(iface);
     if (!hw)
     {
       ROS_ERROR("Failed on dynamic_cast<T>(hw) for T = [%s]. This should never happen",
@@ -146,6 +146,22 @@ public:
     return hw;
   }
 
+  /**
+   * \brief Get a hardware interface by the name of its type.
+   *
+   * This is the lookup behind \ref get. Derived classes can override it to
+   * provide interfaces that are not registered with \ref registerInterface
+   * (eg. to layer interfaces on top of those of another \ref RobotHW).
+   *
+   * \param name The demangled name of the hardware interface type
+   * \return A pointer to the hardware interface or \c NULL
+   */
+  virtual HardwareInterface* getInterface(const std::string& name) const
+  {
+    InterfaceMap::const_iterator it = interfaces_.find(name);
+    return (it != interfaces_.end()) ? it->second : NULL;
+  }
+
   /*\}*/
 
 private:
@@ -112,6 +112,53 @@ TEST_F(RobotHWTest, InterfaceRewriting)
   EXPECT_EQ(2, state_iface_ptr->getNames().size());
 }
 
+namespace
+{
+// Robot hardware that provides its own interfaces, and falls back to those of another one
+class LayeredRobotHW : public RobotHW
+{
+public:
+  LayeredRobotHW(RobotHW* base) : base_(base) {}
+
+  virtual HardwareInterface* getInterface(const std::string& name) const
+  {
+    HardwareInterface* iface = RobotHW::getInterface(name);
+    return iface ? iface : base_->getInterface(name);
+  }
+
+private:
+  RobotHW* base_;
+};
+}
+
+TEST_F(RobotHWTest, InterfaceLookupOverride)
+{
+  JointStateInterface state_iface;
+  state_iface.registerHandle(hs1);
+
+  EffortJointInterface eff_cmd_iface;
+  eff_cmd_iface.registerHandle(hc1);
+
+  EffortJointInterface layer_eff_cmd_iface;
+  layer_eff_cmd_iface.registerHandle(hc2);
+
+  RobotHW base;
+  base.registerInterface(&state_iface);
+  base.registerInterface(&eff_cmd_iface);
+
+  LayeredRobotHW hw(&base);
+  hw.registerInterface(&layer_eff_cmd_iface);
+
+  // Interfaces of the layer take precedence, the others come from the base
+  EXPECT_TRUE(&layer_eff_cmd_iface == hw.get<EffortJointInterface>());
+  EXPECT_TRUE(&state_iface == hw.get<JointStateInterface>());
+  EXPECT_FALSE(hw.get<PositionJointInterface>());
+
+  // Lookup by type name
+  EXPECT_TRUE(&eff_cmd_iface == base.getInterface("hardware_interface::EffortJointInterface"));
+  EXPECT_FALSE(base.getInterface("hardware_interface::PositionJointInterface"));
+}
+
 TEST_F(RobotHWTest, ConflictChecking)
 {
   ControllerInfo info1;
@@ -0,0 +1,523 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013, PAL Robotics S.L.
+// Copyright (c) 2008, Willow Garage, Inc.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of hiDOF, Inc. nor the names of its
+//     contributors may be used to endorse or promote products derived from
+//     this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef JOINT_LIMITS_INTERFACE_JOINT_LIMITS_ENGINE_H
+#define JOINT_LIMITS_INTERFACE_JOINT_LIMITS_ENGINE_H
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <ros/duration.h>
+
+#include <hardware_interface/joint_command_interface.h>
+
+#include <joint_limits_interface/joint_limits.h>
+#include <joint_limits_interface/joint_limits_interface.h>
+#include <joint_limits_interface/joint_limits_interface_exception.h>
+
+namespace joint_limits_interface
+{
+
+namespace internal
+{
+
+/**
+ * \brief Joint state and command lanes shared by all limits engines.
+ *
+ * Joint handles are kept in registration order, and the values they point to are copied in and out of contiguous
+ * arrays once per cycle, so that the limits computations run over plain arrays of doubles.
+ */
+class JointLimitsEngineBase
+{
+public:
+  /** \return Number of registered joints. */
+  std::size_t size() const {return handles_.size();}
+
+  /** \return Names of registered joints, in registration order. */
+  std::vector<std::string> getNames() const
+  {
+    std::vector<std::string> out;
+    out.reserve(handles_.size());
+    for (std::size_t i = 0; i < handles_.size(); ++i) {out.push_back(handles_[i].getName());}
+    return out;
+  }
+
+protected:
+  void addHandle(const hardware_interface::JointHandle& jh)
+  {
+    handles_.push_back(jh);
+    pos_.push_back(0.0);
+    vel_.push_back(0.0);
+    cmd_.push_back(0.0);
+  }
+
+  void gatherPositions()
+  {
+    for (std::size_t i = 0; i < handles_.size(); ++i) {pos_[i] = handles_[i].getPosition();}
+  }
+
+  void gatherVelocities()
+  {
+    for (std::size_t i = 0; i < handles_.size(); ++i) {vel_[i] = handles_[i].getVelocity();}
+  }
+
+  void gatherCommands()
+  {
+    for (std::size_t i = 0; i < handles_.size(); ++i) {cmd_[i] = handles_[i].getCommand();}
+  }
+
+  void scatterCommands()
+  {
+    for (std::size_t i = 0; i < handles_.size(); ++i) {handles_[i].setCommand(cmd_[i]);}
+  }
+
+  /** \brief Value standing in for a missing limit, such that clamping against it is a no-op. */
+  static double unbounded() {return std::numeric_limits<double>::infinity();}
+
+  std::vector<hardware_interface::JointHandle> handles_;
+  std::vector<double> pos_;
+  std::vector<double> vel_;
+  std::vector<double> cmd_;
+};
+
+}
+
+/**
+ * \brief Enforce the same limits as \ref PositionJointSoftLimitsHandle on a set of joints at once.
+ *
+ * Limits are stored as structure-of-arrays. Missing position limits are encoded at registration time as infinite
+ * bounds, so the per-cycle computation is free of data-dependent branches. Angle wraparound is honored as in
+ * \ref PositionJointSoftLimitsHandle.
+ */
+class PositionJointSoftLimitsEngine : public internal::JointLimitsEngineBase
+{
+public:
+  PositionJointSoftLimitsEngine() : has_acceleration_limits_(false) {}
+
+  /**
+   * \brief Add a joint to the engine. Not real-time safe.
+   * \throw JointLimitsInterfaceException If \e limits has no velocity limits specification.
+   */
+  void registerJoint(const hardware_interface::JointHandle& jh,
+                     const JointLimits&                     limits,
+                     const SoftJointLimits&                 soft_limits)
+  {
+    if (!limits.has_velocity_limits)
+    {
+      throw JointLimitsInterfaceException("Cannot enforce limits for joint '" + jh.getName() +
+                                           "'. It has no velocity limits specification.");
+    }
+
+    addHandle(jh);
+    max_vel_.push_back(limits.max_velocity);
+    max_vel_dt_.push_back(0.0);
+    k_pos_dt_.push_back(0.0);
+    max_acc_.push_back(limits.has_acceleration_limits ? limits.max_acceleration : unbounded());
+    max_acc_dt2_.push_back(0.0);
+    has_acceleration_limits_ = has_acceleration_limits_ || limits.has_acceleration_limits;
+    period_cache_ = internal::PeriodCache(); // Force recomputing period-dependent terms
+    wrap_.push_back(limits.angle_wraparound && !limits.has_position_limits);
+    if (limits.has_position_limits)
+    {
+      min_pos_.push_back(limits.min_position);
+      max_pos_.push_back(limits.max_position);
+      soft_min_pos_.push_back(soft_limits.min_position);
+      soft_max_pos_.push_back(soft_limits.max_position);
+      k_pos_.push_back(soft_limits.k_position);
+    }
+    else
+    {
+      // Velocity bounds saturate to the velocity limit, position bounds never bind
+      min_pos_.push_back(-unbounded());
+      max_pos_.push_back( unbounded());
+      soft_min_pos_.push_back(-unbounded());
+      soft_max_pos_.push_back( unbounded());
+      k_pos_.push_back(1.0);
+    }
+  }
+
+  /** \name Real-Time Safe Functions
+   *\{*/
+  /** \brief Enforce limits for all registered joints. */
+  void enforceLimits(const ros::Duration& period)
+  {
+    using internal::saturate;
+
+    const double dt = period.toSec();
+    assert(dt > 0.0);
+
+    const std::size_t n = size();
+    if (period_cache_.update(dt))
+    {
+      for (std::size_t i = 0; i < n; ++i)
+      {
+        k_pos_dt_[i]    = k_pos_[i] * dt;
+        max_vel_dt_[i]  = max_vel_[i] * dt;
+        max_acc_dt2_[i] = max_acc_[i] * dt * dt;
+      }
+    }
+
+    gatherPositions();
+    if (has_acceleration_limits_) {gatherVelocities();}
+    gatherCommands();
+
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      const double pos = pos_[i];
+      const double soft_min_dpos = saturate(-k_pos_dt_[i] * (pos - soft_min_pos_[i]), -max_vel_dt_[i], max_vel_dt_[i]);
+      const double soft_max_dpos = saturate(-k_pos_dt_[i] * (pos - soft_max_pos_[i]), -max_vel_dt_[i], max_vel_dt_[i]);
+
+      // Infinite acceleration bounds of joints without acceleration limits leave the soft bounds untouched
+      const double dpos = vel_[i] * dt;
+      const double min_dpos = saturate(dpos - max_acc_dt2_[i], soft_min_dpos, soft_max_dpos);
+      const double max_dpos = saturate(dpos + max_acc_dt2_[i], soft_min_dpos, soft_max_dpos);
+
+      const double pos_low  = std::max(pos + min_dpos, min_pos_[i]);
+      const double pos_high = std::min(pos + max_dpos, max_pos_[i]);
+
+      // Commands of joints with angle wraparound are moved to the revolution closest to the current position
+      const double cmd = wrap_[i] ? pos + shortestAngularDistance(pos, cmd_[i]) : cmd_[i];
+
+      cmd_[i] = saturate(cmd, pos_low, pos_high);
+    }
+
+    scatterCommands();
+  }
+  /*\}*/
+
+private:
+  std::vector<char>   wrap_;
+  std::vector<double> min_pos_;
+  std::vector<double> max_pos_;
+  std::vector<double> soft_min_pos_;
+  std::vector<double> soft_max_pos_;
+  std::vector<double> k_pos_;
+  std::vector<double> max_vel_;
+  std::vector<double> max_acc_;
+  bool has_acceleration_limits_;
+
+  internal::PeriodCache period_cache_;
+  std::vector<double> k_pos_dt_;
+  std::vector<double> max_vel_dt_;
+  std::vector<double> max_acc_dt2_;
+};
+
+/** \brief Enforce the same limits as \ref EffortJointSaturationHandle on a set of joints at once. */
+class EffortJointSaturationEngine : public internal::JointLimitsEngineBase
+{
+public:
+  /** \brief Add a joint to the engine. Not real-time safe. */
+  void registerJoint(const hardware_interface::JointHandle& jh, const JointLimits& limits)
+  {
+    addHandle(jh);
+    max_eff_.push_back(limits.has_effort_limits   ? limits.max_effort   : unbounded());
+    max_vel_.push_back(limits.has_velocity_limits ? limits.max_velocity : unbounded());
+    min_pos_.push_back(limits.has_position_limits ? limits.min_position : -unbounded());
+    max_pos_.push_back(limits.has_position_limits ? limits.max_position :  unbounded());
+  }
+
+  /** \name Real-Time Safe Functions
+   *\{*/
+  /** \brief Enforce limits for all registered joints. */
+  void enforceLimits(const ros::Duration& /* period */)
+  {
+    using internal::saturate;
+
+    gatherPositions();
+    gatherVelocities();
+    gatherCommands();
+
+    const std::size_t n = size();
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      // Effort pushing the joint further beyond a position or velocity limit is not allowed
+      const bool block_neg = pos_[i] < min_pos_[i] || vel_[i] < -max_vel_[i];
+      const bool block_pos = pos_[i] > max_pos_[i] || vel_[i] >  max_vel_[i];
+      const double min_eff = block_neg ? 0.0 : -max_eff_[i];
+      const double max_eff = block_pos ? 0.0 :  max_eff_[i];
+
+      cmd_[i] = saturate(cmd_[i], min_eff, max_eff);
+    }
+
+    scatterCommands();
+  }
+  /*\}*/
+
+private:
+  std::vector<double> min_pos_;
+  std::vector<double> max_pos_;
+  std::vector<double> max_vel_;
+  std::vector<double> max_eff_;
+};
+
+/**
+ * \brief Enforce the same limits as \ref EffortJointSoftLimitsHandle on a set of joints at once.
+ *
+ * Missing position limits are encoded at registration time as infinite bounds, as in
+ * \ref PositionJointSoftLimitsEngine.
+ */
+class EffortJointSoftLimitsEngine : public internal::JointLimitsEngineBase
+{
+public:
+  /**
+   * \brief Add a joint to the engine. Not real-time safe.
+   * \throw JointLimitsInterfaceException If \e limits has no velocity or effort limits specification.
+   */
+  void registerJoint(const hardware_interface::JointHandle& jh,
+                     const JointLimits&                     limits,
+                     const SoftJointLimits&                 soft_limits)
+  {
+    if (!limits.has_velocity_limits)
+    {
+      throw JointLimitsInterfaceException("Cannot enforce limits for joint '" + jh.getName() +
+                                           "'. It has no velocity limits specification.");
+    }
+    if (!limits.has_effort_limits)
+    {
+      throw JointLimitsInterfaceException("Cannot enforce limits for joint '" + jh.getName() +
+                                           "'. It has no effort limits specification.");
+    }
+
+    addHandle(jh);
+    max_vel_.push_back(limits.max_velocity);
+    max_eff_.push_back(limits.max_effort);
+    k_vel_.push_back(soft_limits.k_velocity);
+    if (limits.has_position_limits)
+    {
+      soft_min_pos_.push_back(soft_limits.min_position);
+      soft_max_pos_.push_back(soft_limits.max_position);
+      k_pos_.push_back(soft_limits.k_position);
+    }
+    else
+    {
+      soft_min_pos_.push_back(-unbounded());
+      soft_max_pos_.push_back( unbounded());
+      k_pos_.push_back(1.0);
+    }
+  }
+
+  /** \name Real-Time Safe Functions
+   *\{*/
+  /** \brief Enforce limits for all registered joints. */
+  void enforceLimits(const ros::Duration& /* period */)
+  {
+    using internal::saturate;
+
+    gatherPositions();
+    gatherVelocities();
+    gatherCommands();
+
+    const std::size_t n = size();
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      const double pos = pos_[i];
+      const double vel = vel_[i];
+      const double soft_min_vel = saturate(-k_pos_[i] * (pos - soft_min_pos_[i]), -max_vel_[i], max_vel_[i]);
+      const double soft_max_vel = saturate(-k_pos_[i] * (pos - soft_max_pos_[i]), -max_vel_[i], max_vel_[i]);
+
+      const double soft_min_eff = saturate(-k_vel_[i] * (vel - soft_min_vel), -max_eff_[i], max_eff_[i]);
+      const double soft_max_eff = saturate(-k_vel_[i] * (vel - soft_max_vel), -max_eff_[i], max_eff_[i]);
+
+      cmd_[i] = saturate(cmd_[i], soft_min_eff, soft_max_eff);
+    }
+
+    scatterCommands();
+  }
+  /*\}*/
+
+private:
+  std::vector<double> soft_min_pos_;
+  std::vector<double> soft_max_pos_;
+  std::vector<double> k_pos_;
+  std::vector<double> k_vel_;
+  std::vector<double> max_vel_;
+  std::vector<double> max_eff_;
+};
+
+/**
+ * \brief Enforce the same limits as \ref VelocityJointSoftLimitsHandle on a set of joints at once.
+ *
+ * Missing position, velocity and acceleration limits are encoded at registration time as infinite bounds.
+ */
+class VelocityJointSoftLimitsEngine : public internal::JointLimitsEngineBase
+{
+public:
+  VelocityJointSoftLimitsEngine() : has_acceleration_limits_(false) {}
+
+  /** \brief Add a joint to the engine. Not real-time safe. */
+  void registerJoint(const hardware_interface::JointHandle& jh,
+                     const JointLimits&                     limits,
+                     const SoftJointLimits&                 soft_limits)
+  {
+    addHandle(jh);
+    max_vel_.push_back(limits.has_velocity_limits ? limits.max_velocity : unbounded());
+    max_acc_.push_back(limits.has_acceleration_limits ? limits.max_acceleration : unbounded());
+    max_acc_dt_.push_back(0.0);
+    has_acceleration_limits_ = has_acceleration_limits_ || limits.has_acceleration_limits;
+    period_cache_ = internal::PeriodCache(); // Force recomputing period-dependent terms
+    if (limits.has_position_limits)
+    {
+      soft_min_pos_.push_back(soft_limits.min_position);
+      soft_max_pos_.push_back(soft_limits.max_position);
+      k_pos_.push_back(soft_limits.k_position);
+    }
+    else
+    {
+      soft_min_pos_.push_back(-unbounded());
+      soft_max_pos_.push_back( unbounded());
+      k_pos_.push_back(1.0);
+    }
+  }
+
+  /** \name Real-Time Safe Functions
+   *\{*/
+  /** \brief Enforce limits for all registered joints. */
+  void enforceLimits(const ros::Duration& period)
+  {
+    using internal::saturate;
+
+    // See VelocityJointSaturationEngine::enforceLimits
+    assert(!has_acceleration_limits_ || period.toSec() > 0.0);
+    const double dt = has_acceleration_limits_ ? period.toSec() : 1.0;
+
+    const std::size_t n = size();
+    if (period_cache_.update(dt))
+    {
+      for (std::size_t i = 0; i < n; ++i) {max_acc_dt_[i] = max_acc_[i] * dt;}
+    }
+
+    gatherPositions();
+    if (has_acceleration_limits_) {gatherVelocities();}
+    gatherCommands();
+
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      const double pos = pos_[i];
+      const double soft_min_vel = saturate(-k_pos_[i] * (pos - soft_min_pos_[i]), -max_vel_[i], max_vel_[i]);
+      const double soft_max_vel = saturate(-k_pos_[i] * (pos - soft_max_pos_[i]), -max_vel_[i], max_vel_[i]);
+
+      const double vel_low  = saturate(vel_[i] - max_acc_dt_[i], soft_min_vel, soft_max_vel);
+      const double vel_high = saturate(vel_[i] + max_acc_dt_[i], soft_min_vel, soft_max_vel);
+
+      cmd_[i] = saturate(cmd_[i], vel_low, vel_high);
+    }
+
+    scatterCommands();
+  }
+  /*\}*/
+
+private:
+  std::vector<double> soft_min_pos_;
+  std::vector<double> soft_max_pos_;
+  std::vector<double> k_pos_;
+  std::vector<double> max_vel_;
+  std::vector<double> max_acc_;
+  bool has_acceleration_limits_;
+
+  internal::PeriodCache period_cache_;
+  std::vector<double> max_acc_dt_;
+};
+
+/**
+ * \brief Enforce the same limits as \ref VelocityJointSaturationHandle on a set of joints at once.
+ *
+ * Missing acceleration limits are encoded at registration time as infinite bounds.
+ */
+class VelocityJointSaturationEngine : public internal::JointLimitsEngineBase
+{
+public:
+  VelocityJointSaturationEngine() : has_acceleration_limits_(false) {}
+
+  /**
+   * \brief Add a joint to the engine. Not real-time safe.
+   * \throw JointLimitsInterfaceException If \e limits has no velocity limits specification.
+   */
+  void registerJoint(const hardware_interface::JointHandle& jh, const JointLimits& limits)
+  {
+    if (!limits.has_velocity_limits)
+    {
+      throw JointLimitsInterfaceException("Cannot enforce limits for joint '" + jh.getName() +
+                                           "'. It has no velocity limits specification.");
+    }
+
+    addHandle(jh);
+    max_vel_.push_back(limits.max_velocity);
+    max_acc_.push_back(limits.has_acceleration_limits ? limits.max_acceleration : unbounded());
+    max_acc_dt_.push_back(0.0);
+    period_cache_ = internal::PeriodCache(); // Force recomputing period-dependent terms
+    has_acceleration_limits_ = has_acceleration_limits_ || limits.has_acceleration_limits;
+  }
+
+  /** \name Real-Time Safe Functions
+   *\{*/
+  /** \brief Enforce limits for all registered joints. */
+  void enforceLimits(const ros::Duration& period)
+  {
+    using internal::saturate;
+
+    // The period only matters if some joint has acceleration limits. Otherwise use a unit period so that infinite
+    // acceleration bounds don't turn into NaNs
+    assert(!has_acceleration_limits_ || period.toSec() > 0.0);
+    const double dt = has_acceleration_limits_ ? period.toSec() : 1.0;
+
+    const std::size_t n = size();
+    if (period_cache_.update(dt))
+    {
+      for (std::size_t i = 0; i < n; ++i) {max_acc_dt_[i] = max_acc_[i] * dt;}
+    }
+
+    if (has_acceleration_limits_) {gatherVelocities();}
+    gatherCommands();
+
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      const double vel_low  = std::max(vel_[i] - max_acc_dt_[i], -max_vel_[i]);
+      const double vel_high = std::min(vel_[i] + max_acc_dt_[i],  max_vel_[i]);
+
+      cmd_[i] = saturate(cmd_[i], vel_low, vel_high);
+    }
+
+    scatterCommands();
+  }
+  /*\}*/
+
+private:
+  std::vector<double> max_vel_;
+  std::vector<double> max_acc_;
+  bool has_acceleration_limits_;
+
+  internal::PeriodCache period_cache_;
+  std::vector<double> max_acc_dt_;
+};
+
+}
+
+#endif
@@ -33,8 +33,14 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <limits>
 
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include <ros/duration.h>
 
@@ -43,10 +49,30 @@
 
 #include <joint_limits_interface/joint_limits.h>
 #include <joint_limits_interface/joint_limits_interface_exception.h>
+#include <joint_limits_interface/joint_limits_violations.h>
 
 namespace joint_limits_interface
 {
 
+/**
+ * \brief Wrap an angle to the <tt>[-pi, pi)</tt> interval.
+ *
+ * Implemented without data-dependent branches, so it is cheap to call every control cycle.
+ */
+inline double wrapAngle(double angle)
+{
+  const double two_pi = 2.0 * M_PI;
+  return angle - two_pi * std::floor((angle + M_PI) / two_pi);
+}
+
+/**
+ * \return Signed angle in <tt>[-pi, pi)</tt> that takes \e from to an angle equivalent to \e to.
+ */
+inline double shortestAngularDistance(double from, double to)
+{
+  return wrapAngle(to - from);
+}
+
 namespace internal
 {
 
@@ -56,115 +82,418 @@ T saturate(const T val, const T min_val, const T max_val)
   return std::min(std::max(val, min_val), max_val);
 }
 
-}
+/**
+ * \brief Remember the control period for which period-dependent limit bounds were last computed.
+ *
+ * Fixed-rate control loops see the same period every cycle, so quantities like <tt>max_velocity * dt</tt> need only
+ * be recomputed when the period actually changes.
+ */
+class PeriodCache
+{
+public:
+  /**
+   * \param tolerance Period changes (in seconds) up to this value are not considered significant. Defaults to one
+   * microsecond, which keeps timing jitter from triggering recomputations.
+   */
+  explicit PeriodCache(double tolerance = 1e-6) : dt_(-1.0), tolerance_(tolerance) {}
 
-/** \brief A handle used to enforce position and velocity limits of a position-controlled joint. */
+  /**
+   * \param dt Current control period, in seconds.
+   * \return True if \e dt differs significantly from the cached period, in which case it becomes the new cached period
+   * and period-dependent quantities should be recomputed.
+   */
+  bool update(double dt)
+  {
+    if (std::abs(dt - dt_) <= tolerance_) {return false;}
+    dt_ = dt;
+    return true;
+  }
 
-// TODO: Leverage %Reflexxes Type II library for acceleration limits handling?
-class PositionJointSoftLimitsHandle
+  /** \return Cached period, in seconds. Negative if \ref update has never been called. */
+  double getPeriod() const {return dt_;}
+
+private:
+  double dt_;
+  double tolerance_;
+};
+
+/**
+ * \brief Double-buffered limits specification of a joint, shared by all copies of its limits handle.
+ *
+ * Writers fill the slot that is not being read and then publish it, so flipping the active slot is a single atomic
+ * store. Readers never block: they copy the active slot and discard the copy (keeping their current limits until
+ * the next attempt) only if two updates were started in the meantime, ie. if the slot may have been overwritten.
+ */
+class LimitsBuffer : private boost::noncopyable
 {
 public:
-  PositionJointSoftLimitsHandle() {}
+  LimitsBuffer(const JointLimits& limits, const SoftJointLimits& soft_limits)
+    : started_(0),
+      published_(0)
+  {
+    slots_[0].limits      = limits;
+    slots_[0].soft_limits = soft_limits;
+  }
 
-  PositionJointSoftLimitsHandle(const hardware_interface::JointHandle& jh,
-                                const JointLimits&                     limits,
-                                const SoftJointLimits&                 soft_limits)
+  /** \brief Publish a new limits specification. Not real-time safe, but never blocks readers. */
+  void write(const JointLimits& limits, const SoftJointLimits& soft_limits)
+  {
+    boost::mutex::scoped_lock lock(write_mutex_);
+
+    // Update number k is written to slot k % 2. Readers of the published slot are unaffected
+    const boost::uint64_t update = published_.load(boost::memory_order_relaxed) + 1;
+    started_.store(update, boost::memory_order_relaxed);
+    boost::atomic_thread_fence(boost::memory_order_release);
+
+    Slot& slot = slots_[update % 2];
+    slot.limits      = limits;
+    slot.soft_limits = soft_limits;
+
+    published_.store(update, boost::memory_order_release);
+  }
+
+  /** \return Latest published soft limits. Not real-time safe. */
+  SoftJointLimits getSoftJointLimits() const
+  {
+    boost::mutex::scoped_lock lock(write_mutex_);
+    return slots_[published_.load(boost::memory_order_relaxed) % 2].soft_limits;
+  }
+
+  /** \name Real-Time Safe Functions
+   *\{*/
+  /**
+   * \brief Copy the published limits specification, if newer than a given version.
+   * \param[in,out] version Version of the caller's limits. Updated on success.
+   * \return True if \e limits and \e soft_limits were overwritten with a newer, consistent specification.
+   */
+  bool read(boost::uint64_t& version, JointLimits& limits, SoftJointLimits& soft_limits) const
+  {
+    const boost::uint64_t published = published_.load(boost::memory_order_acquire);
+    if (published == version) {return false;}
+
+    const Slot& slot = slots_[published % 2];
+    const JointLimits     new_limits      = slot.limits;
+    const SoftJointLimits new_soft_limits = slot.soft_limits;
+
+    // The copy is only valid if no update targeting the same slot has been started while taking it
+    boost::atomic_thread_fence(boost::memory_order_acquire);
+    if (started_.load(boost::memory_order_relaxed) > published + 1) {return false;}
+
+    limits      = new_limits;
+    soft_limits = new_soft_limits;
+    version     = published;
+    return true;
+  }
+  /*\}*/
+
+private:
+  struct Slot
+  {
+    JointLimits     limits;
+    SoftJointLimits soft_limits;
+  };
+
+  Slot slots_[2];
+  boost::atomic<boost::uint64_t> started_;
+  boost::atomic<boost::uint64_t> published_;
+  mutable boost::mutex write_mutex_;
+};
+
+/**
+ * \brief Joint handle and limits common to all limits handles.
+ *
+ * Also offers wrap-aware accessors to the joint position, so users of joints with angle wraparound don't need to unwrap
+ * angles themselves, keeps track of the commands modified to honor limits, and allows replacing limits at runtime.
+ */
+class JointLimitsHandleBase
+{
+public:
+  /** \return Joint name. */
+  std::string getName() const {return jh_.getName();}
+
+  /**
+   * \brief Replace the limits of the joint, keeping its current soft limits.
+   *
+   * All copies of the handle, including the one registered in a \ref JointLimitsInterface, pick up the new limits at
+   * the start of their next \p enforceLimits() call. Not real-time safe, but never blocks the real-time thread, so it
+   * can be called while limits are being enforced (eg. for payload-dependent limits).
+   * \throw JointLimitsInterfaceException if \e limits lacks a specification required by the handle.
+   */
+  void setLimits(const JointLimits& limits)
+  {
+    assert(limits_buffer_);
+    setLimits(limits, limits_buffer_->getSoftJointLimits());
+  }
+
+  /** \brief Replace the limits and soft limits of the joint. \sa setLimits(const JointLimits&) */
+  void setLimits(const JointLimits& limits, const SoftJointLimits& soft_limits)
+  {
+    assert(limits_buffer_);
+    checkLimits(limits);
+    limits_buffer_->write(limits, soft_limits);
+  }
+
+  /**
+   * \return True if the joint position wraps around, ie. the joint has the \p angle_wraparound flag set and no position
+   * limits (eg. a continuous joint).
+   */
+  bool hasAngleWraparound() const {return limits_.angle_wraparound && !limits_.has_position_limits;}
+
+  /** \return Joint position, wrapped to <tt>[-pi, pi)</tt> if the joint has angle wraparound. */
+  double getPosition() const
+  {
+    const double pos = jh_.getPosition();
+    return hasAngleWraparound() ? wrapAngle(pos) : pos;
+  }
+
+  /**
+   * \return Offset from the current joint position to \e target. If the joint has angle wraparound, this is the
+   * shortest angular distance.
+   */
+  double getPositionError(double target) const
+  {
+    const double pos = jh_.getPosition();
+    return hasAngleWraparound() ? shortestAngularDistance(pos, target) : target - pos;
+  }
+
+  /**
+   * \return Limit violation counters of the joint, shared by all copies of the handle. Null for default-constructed
+   * handles.
+   */
+  boost::shared_ptr<const JointLimitsViolations> getViolations() const {return violations_;}
+
+protected:
+  JointLimitsHandleBase() : required_limits_(0), limits_version_(0) {}
+
+  /**
+   * \param required_limits Bitmask of the limit types the handle can't do without, eg.
+   * <tt>1 << VELOCITY_LIMIT</tt>.
+   * \throw JointLimitsInterfaceException if \e limits lacks any of the required limits.
+   */
+  JointLimitsHandleBase(const hardware_interface::JointHandle& jh,
+                        const JointLimits&                     limits,
+                        const SoftJointLimits&                 soft_limits,
+                        unsigned int                           required_limits)
     : jh_(jh),
       limits_(limits),
-      soft_limits_(soft_limits)
+      soft_limits_(soft_limits),
+      violations_(new JointLimitsViolations),
+      required_limits_(required_limits),
+      limits_buffer_(new LimitsBuffer(limits, soft_limits)),
+      limits_version_(0)
+  {
+    checkLimits(limits);
+  }
+
+  /**
+   * \brief Adopt limits set through \ref setLimits since the last call, if any. Real-time safe.
+   * \return True if \p limits_ and \p soft_limits_ changed, in which case derived quantities must be recomputed.
+   */
+  bool updateLimits()
+  {
+    assert(limits_buffer_);
+    return limits_buffer_->read(limits_version_, limits_, soft_limits_);
+  }
+
+  /** \brief Account for a command changed from \e cmd to \e enforced_cmd to honor limits of type \e type. */
+  void recordViolation(LimitType type, double cmd, double enforced_cmd)
+  {
+    if (enforced_cmd != cmd) {violations_->record(type, std::abs(enforced_cmd - cmd));}
+  }
+
+  /**
+   * \return Position command expressed in the revolution closest to \e reference if the joint has angle wraparound,
+   * \e cmd otherwise.
+   */
+  double unwrapCommand(double cmd, double reference) const
+  {
+    return hasAngleWraparound() ? reference + shortestAngularDistance(reference, cmd) : cmd;
+  }
+
+  hardware_interface::JointHandle jh_;
+  JointLimits limits_;
+  SoftJointLimits soft_limits_;
+  boost::shared_ptr<JointLimitsViolations> violations_;
+
+private:
+  void checkLimits(const JointLimits& limits) const
   {
-    if (!limits.has_velocity_limits)
+    const bool has_limits[LIMIT_TYPE_COUNT] = {limits.has_position_limits,
+                                               limits.has_velocity_limits,
+                                               limits.has_acceleration_limits,
+                                               limits.has_jerk_limits,
+                                               limits.has_effort_limits};
+    for (unsigned int i = 0; i < LIMIT_TYPE_COUNT; ++i)
     {
-      throw JointLimitsInterfaceException("Cannot enforce limits for joint '" + getName() +
-                                           "'. It has no velocity limits specification.");
+      if ((required_limits_ & (1u << i)) && !has_limits[i])
+      {
+        throw JointLimitsInterfaceException("Cannot enforce limits for joint '" + getName() + "'. It has no " +
+                                            getLimitTypeName(static_cast<LimitType>(i)) + " limits specification.");
+      }
     }
   }
 
-  /** \return Joint name. */
-  std::string getName() const {return jh_.getName();}
+  unsigned int required_limits_;
+  boost::shared_ptr<LimitsBuffer> limits_buffer_;
+  boost::uint64_t limits_version_;
+};
+
+/** \brief Command history of a jerk-limited joint. */
+struct JerkLimitsState : private boost::noncopyable
+{
+  JerkLimitsState() : initialized(false), reset_requested(false), cmd(0.0), vel(0.0), acc(0.0) {}
+
+  /// Clear \ref initialized if a reset was requested since the last call. Only called by the thread enforcing limits.
+  void consumeResetRequest()
+  {
+    if (reset_requested.load(boost::memory_order_relaxed) &&
+        reset_requested.exchange(false, boost::memory_order_acquire)) {initialized = false;}
+  }
+
+  bool                initialized;     ///< False until the first command is enforced, or after a reset.
+  boost::atomic<bool> reset_requested; ///< Set from any thread to have the history forgotten.
+  double              cmd;             ///< Last enforced command.
+  double              vel;             ///< Velocity implied by the last enforced commands (position-controlled only).
+  double              acc;             ///< Acceleration implied by the last enforced commands.
+};
+
+}
+
+/** \brief A handle used to enforce position and velocity limits of a position-controlled joint. */
+
+// TODO: Leverage %Reflexxes Type II library for acceleration limits handling?
+class PositionJointSoftLimitsHandle : public internal::JointLimitsHandleBase
+{
+public:
+  PositionJointSoftLimitsHandle() : k_position_dt_(0.0), max_velocity_dt_(0.0), max_acceleration_dt2_(0.0) {}
+
+  PositionJointSoftLimitsHandle(const hardware_interface::JointHandle& jh,
+                                const JointLimits&                     limits,
+                                const SoftJointLimits&                 soft_limits)
+    : internal::JointLimitsHandleBase(jh, limits, soft_limits, 1u << VELOCITY_LIMIT),
+      k_position_dt_(0.0),
+      max_velocity_dt_(0.0),
+      max_acceleration_dt2_(0.0)
+  {}
 
   /**
    * \brief Enforce position and velocity limits for a joint subject to soft limits.
    *
-   * If the joint has no position limits (eg. a continuous joint), only velocity limits will be enforced.
+   * If the joint has no position limits (eg. a continuous joint), only velocity limits will be enforced. If it also
+   * has angle wraparound, the command is taken as an angle, and the enforced command lies in the revolution closest
+   * to the current position.
+   *
+   * If the joint has acceleration limits, the velocity implied by the command is also kept within reach of the
+   * measured joint velocity in one control period. Position and velocity limits take precedence over acceleration
+   * limits.
    * \param period Control period.
    */
   void enforceLimits(const ros::Duration& period)
   {
-    assert(period.toSec() > 0.0);
+    const double dt = period.toSec();
+    assert(dt > 0.0);
 
     using internal::saturate;
 
+    // Period-dependent terms only change with the period, or with the limits
+    if (updateLimits()) {period_cache_ = internal::PeriodCache();}
+    if (period_cache_.update(dt))
+    {
+      k_position_dt_        = soft_limits_.k_position * dt;
+      max_velocity_dt_      = limits_.max_velocity * dt;
+      max_acceleration_dt2_ = limits_.max_acceleration * dt * dt;
+    }
+
     // Current position
     const double pos = jh_.getPosition();
 
-    // Velocity bounds
-    double soft_min_vel;
-    double soft_max_vel;
+    // Position increment bounds, ie. velocity bounds integrated over the control period
+    double soft_min_dpos;
+    double soft_max_dpos;
 
     if (limits_.has_position_limits)
     {
       // Velocity bounds depend on the velocity limit and the proximity to the position limit
-      soft_min_vel = saturate(-soft_limits_.k_position * (pos - soft_limits_.min_position),
-                              -limits_.max_velocity,
-                               limits_.max_velocity);
+      soft_min_dpos = saturate(-k_position_dt_ * (pos - soft_limits_.min_position),
+                               -max_velocity_dt_,
+                                max_velocity_dt_);
 
-      soft_max_vel = saturate(-soft_limits_.k_position * (pos - soft_limits_.max_position),
-                              -limits_.max_velocity,
-                               limits_.max_velocity);
+      soft_max_dpos = saturate(-k_position_dt_ * (pos - soft_limits_.max_position),
+                               -max_velocity_dt_,
+                                max_velocity_dt_);
     }
     else
     {
       // No position limits, eg. continuous joints
-      soft_min_vel = -limits_.max_velocity;
-      soft_max_vel =  limits_.max_velocity;
+      soft_min_dpos = -max_velocity_dt_;
+      soft_max_dpos =  max_velocity_dt_;
+    }
+
+    // Keep track of the limit type behind each bound, for accounting violations
+    LimitType low_type  = soft_min_dpos == -max_velocity_dt_ ? VELOCITY_LIMIT : POSITION_LIMIT;
+    LimitType high_type = soft_max_dpos ==  max_velocity_dt_ ? VELOCITY_LIMIT : POSITION_LIMIT;
+
+    if (limits_.has_acceleration_limits)
+    {
+      // Velocity change over the control period is bounded, but (soft) position and velocity limits take precedence
+      const double dpos = jh_.getVelocity() * dt;
+      const double min_dpos = saturate(dpos - max_acceleration_dt2_, soft_min_dpos, soft_max_dpos);
+      const double max_dpos = saturate(dpos + max_acceleration_dt2_, soft_min_dpos, soft_max_dpos);
+      if (min_dpos > soft_min_dpos) {low_type  = ACCELERATION_LIMIT;}
+      if (max_dpos < soft_max_dpos) {high_type = ACCELERATION_LIMIT;}
+      soft_min_dpos = min_dpos;
+      soft_max_dpos = max_dpos;
     }
 
     // Position bounds
-    const double dt = period.toSec();
-    double pos_low  = pos + soft_min_vel * dt;
-    double pos_high = pos + soft_max_vel * dt;
+    double pos_low  = pos + soft_min_dpos;
+    double pos_high = pos + soft_max_dpos;
 
     if (limits_.has_position_limits)
     {
       // This extra measure safeguards against pathological cases, like when the soft limit lies beyond the hard limit
+      if (limits_.min_position > pos_low)  {low_type  = POSITION_LIMIT;}
+      if (limits_.max_position < pos_high) {high_type = POSITION_LIMIT;}
       pos_low  = std::max(pos_low,  limits_.min_position);
       pos_high = std::min(pos_high, limits_.max_position);
     }
 
     // Saturate position command according to bounds
-    const double pos_cmd = saturate(jh_.getCommand(),
+    const double cmd = unwrapCommand(jh_.getCommand(), pos);
+    const double pos_cmd = saturate(cmd,
                                     pos_low,
                                     pos_high);
     jh_.setCommand(pos_cmd);
+
+    recordViolation(cmd < pos_low ? low_type : high_type, cmd, pos_cmd);
   }
 
 private:
-  hardware_interface::JointHandle jh_;
-  JointLimits limits_;
-  SoftJointLimits soft_limits_;
+  internal::PeriodCache period_cache_;
+  double k_position_dt_;
+  double max_velocity_dt_;
+  double max_acceleration_dt2_;
 };
 
 /** \brief A handle used to enforce position, velocity, and effort limits of an effort-controlled joint that does not
     have soft limits. */
-class EffortJointSaturationHandle
+class EffortJointSaturationHandle : public internal::JointLimitsHandleBase
 {
 public:
   EffortJointSaturationHandle(const hardware_interface::JointHandle& jh, const JointLimits& limits)
-  {
-    jh_ = jh;
-    limits_ = limits;
-  }
-
-  /** \return Joint name. */
-  std::string getName() const {return jh_.getName();}
+    : internal::JointLimitsHandleBase(jh, limits, SoftJointLimits(), 0)
+  {}
 
   /**
    * \brief Enforce position, velocity, and effort limits for a joint that is not subject to soft limits.
    */
   void enforceLimits(const ros::Duration& /* period */)
   {
+    updateLimits();
+
     double min_eff, max_eff;
+    LimitType min_eff_type = EFFORT_LIMIT;
+    LimitType max_eff_type = EFFORT_LIMIT;
     if (limits_.has_effort_limits)
     {
       min_eff = -limits_.max_effort;
@@ -180,32 +509,45 @@ public:
     {
       const double pos = jh_.getPosition();
       if (pos < limits_.min_position)
+      {
         min_eff = 0;
+        min_eff_type = POSITION_LIMIT;
+      }
       else if (pos > limits_.max_position)
+      {
         max_eff = 0;
+        max_eff_type = POSITION_LIMIT;
+      }
     } 
 
     if (limits_.has_velocity_limits)
     {
       const double vel = jh_.getVelocity();
       if (vel < -limits_.max_velocity)
+      {
         min_eff = 0;
+        min_eff_type = VELOCITY_LIMIT;
+      }
       else if (vel > limits_.max_velocity)
+      {
         max_eff = 0;
+        max_eff_type = VELOCITY_LIMIT;
+      }
     }
 
-    jh_.setCommand(internal::saturate(jh_.getCommand(), min_eff, max_eff));
+    const double cmd = jh_.getCommand();
+    const double eff_cmd = internal::saturate(cmd, min_eff, max_eff);
+    jh_.setCommand(eff_cmd);
+
+    recordViolation(cmd < min_eff ? min_eff_type : max_eff_type, cmd, eff_cmd);
   }
 
-private:
-  hardware_interface::JointHandle jh_;
-  JointLimits limits_;
 };
 
 /** \brief A handle used to enforce position, velocity and effort limits of an effort-controlled joint. */
 
 // TODO: This class is untested!. Update unit tests accordingly.
-class EffortJointSoftLimitsHandle
+class EffortJointSoftLimitsHandle : public internal::JointLimitsHandleBase
 {
 public:
   EffortJointSoftLimitsHandle() {}
@@ -213,24 +555,8 @@ public:
   EffortJointSoftLimitsHandle(const hardware_interface::JointHandle& jh,
                               const JointLimits&                     limits,
                               const SoftJointLimits&                 soft_limits)
-  : jh_(jh),
-    limits_(limits),
-    soft_limits_(soft_limits)
-  {
-    if (!limits.has_velocity_limits)
-    {
-      throw JointLimitsInterfaceException("Cannot enforce limits for joint '" + getName() +
-                                           "'. It has no velocity limits specification.");
-    }
-    if (!limits.has_effort_limits)
-    {
-      throw JointLimitsInterfaceException("Cannot enforce limits for joint '" + getName() +
-                                           "'. It has no effort limits specification.");
-    }
-  }
-
-  /** \return Joint name. */
-  std::string getName() const {return jh_.getName();}
+  : internal::JointLimitsHandleBase(jh, limits, soft_limits, 1u << VELOCITY_LIMIT | 1u << EFFORT_LIMIT)
+  {}
 
   /**
    * \brief Enforce position, velocity and effort limits for a joint subject to soft limits.
@@ -241,6 +567,8 @@ public:
   {
     using internal::saturate;
 
+    updateLimits();
+
     // Current state
     const double pos = jh_.getPosition();
     const double vel = jh_.getVelocity();
@@ -277,38 +605,33 @@ public:
                                           limits_.max_effort);
 
     // Saturate effort command according to bounds
-    const double eff_cmd = saturate(jh_.getCommand(),
+    const double cmd = jh_.getCommand();
+    const double eff_cmd = saturate(cmd,
                                     soft_min_eff,
                                     soft_max_eff);
     jh_.setCommand(eff_cmd);
-  }
 
-private:
-  hardware_interface::JointHandle jh_;
-  JointLimits limits_;
-  SoftJointLimits soft_limits_;
+    // Active bound is set by the effort limit, the velocity limit, or the (soft) position limits
+    const bool   low_bound = cmd < soft_min_eff;
+    const double sign      = low_bound ? -1.0 : 1.0;
+    LimitType type = POSITION_LIMIT;
+    if      ((low_bound ? soft_min_eff : soft_max_eff) == sign * limits_.max_effort)   {type = EFFORT_LIMIT;}
+    else if ((low_bound ? soft_min_vel : soft_max_vel) == sign * limits_.max_velocity) {type = VELOCITY_LIMIT;}
+    recordViolation(type, cmd, eff_cmd);
+  }
 };
 
 
 /** \brief A handle used to enforce velocity and acceleration limits of a velocity-controlled joint. */
-class VelocityJointSaturationHandle
+class VelocityJointSaturationHandle : public internal::JointLimitsHandleBase
 {
 public:
-  VelocityJointSaturationHandle () {}
+  VelocityJointSaturationHandle () : max_acceleration_dt_(0.0) {}
 
   VelocityJointSaturationHandle(const hardware_interface::JointHandle& jh, const JointLimits& limits)
-    : jh_(jh),
-      limits_(limits)
-  {
-    if (!limits.has_velocity_limits)
-    {
-      throw JointLimitsInterfaceException("Cannot enforce limits for joint '" + getName() +
-                                           "'. It has no velocity limits specification.");
-    }
-  }
-
-  /** \return Joint name. */
-  std::string getName() const {return jh_.getName();}
+    : internal::JointLimitsHandleBase(jh, limits, SoftJointLimits(), 1u << VELOCITY_LIMIT),
+      max_acceleration_dt_(0.0)
+  {}
 
   /**
    * \brief Enforce joint velocity and acceleration limits.
@@ -318,18 +641,23 @@ public:
   {
     using internal::saturate;
 
+    if (updateLimits()) {period_cache_ = internal::PeriodCache();}
+
     // Velocity bounds
     double vel_low;
     double vel_high;
 
     if (limits_.has_acceleration_limits)
     {
-      assert(period.toSec() > 0.0);
-      const double vel = jh_.getVelocity();
-      const double dt  = period.toSec();
+      const double dt = period.toSec();
+      assert(dt > 0.0);
+
+      // Maximum velocity increment only changes with the period
+      if (period_cache_.update(dt)) {max_acceleration_dt_ = limits_.max_acceleration * dt;}
 
-      vel_low  = std::max(vel - limits_.max_acceleration * dt, -limits_.max_velocity);
-      vel_high = std::min(vel + limits_.max_acceleration * dt,  limits_.max_velocity);
+      const double vel = jh_.getVelocity();
+      vel_low  = std::max(vel - max_acceleration_dt_, -limits_.max_velocity);
+      vel_high = std::min(vel + max_acceleration_dt_,  limits_.max_velocity);
     }
     else
     {
@@ -338,15 +666,328 @@ public:
     }
 
     // Saturate velocity command according to limits
-    const double vel_cmd = saturate(jh_.getCommand(),
+    const double cmd = jh_.getCommand();
+    const double vel_cmd = saturate(cmd,
                                     vel_low,
                                     vel_high);
     jh_.setCommand(vel_cmd);
+
+    const bool velocity_bound = cmd < vel_low ? vel_low  == -limits_.max_velocity
+                                              : vel_high ==  limits_.max_velocity;
+    recordViolation(velocity_bound ? VELOCITY_LIMIT : ACCELERATION_LIMIT, cmd, vel_cmd);
   }
 
 private:
-  hardware_interface::JointHandle jh_;
-  JointLimits limits_;
+  internal::PeriodCache period_cache_;
+  double max_acceleration_dt_;
+};
+
+/**
+ * \brief A handle used to enforce position, velocity and acceleration limits of a velocity-controlled joint subject
+ * to soft limits.
+ *
+ * The velocity bounds depend on the proximity to the soft position limits, as in \ref PositionJointSoftLimitsHandle.
+ */
+class VelocityJointSoftLimitsHandle : public internal::JointLimitsHandleBase
+{
+public:
+  VelocityJointSoftLimitsHandle() : max_vel_limit_(0.0), max_acceleration_dt_(0.0) {}
+
+  VelocityJointSoftLimitsHandle(const hardware_interface::JointHandle& jh,
+                                const JointLimits&                     limits,
+                                const SoftJointLimits&                 soft_limits)
+    : internal::JointLimitsHandleBase(jh, limits, soft_limits, 0),
+      max_vel_limit_(getMaxVelocityLimit(limits)),
+      max_acceleration_dt_(0.0)
+  {}
+
+  /**
+   * \brief Enforce position, velocity and acceleration limits for a joint subject to soft limits.
+   *
+   * If the joint has no position limits (eg. a continuous joint), only velocity and acceleration limits will be
+   * enforced. Position and velocity limits take precedence over acceleration limits.
+   * \param period Control period.
+   */
+  void enforceLimits(const ros::Duration& period)
+  {
+    using internal::saturate;
+
+    if (updateLimits())
+    {
+      max_vel_limit_ = getMaxVelocityLimit(limits_);
+      period_cache_  = internal::PeriodCache();
+    }
+
+    // Velocity bounds
+    double soft_min_vel;
+    double soft_max_vel;
+
+    if (limits_.has_position_limits)
+    {
+      // Velocity bounds depend on the velocity limit and the proximity to the position limit
+      const double pos = jh_.getPosition();
+      soft_min_vel = saturate(-soft_limits_.k_position * (pos - soft_limits_.min_position),
+                              -max_vel_limit_,
+                               max_vel_limit_);
+
+      soft_max_vel = saturate(-soft_limits_.k_position * (pos - soft_limits_.max_position),
+                              -max_vel_limit_,
+                               max_vel_limit_);
+    }
+    else
+    {
+      // No position limits, eg. continuous joints
+      soft_min_vel = -max_vel_limit_;
+      soft_max_vel =  max_vel_limit_;
+    }
+
+    // Keep track of the limit type behind each bound, for accounting violations
+    LimitType low_type  = soft_min_vel == -max_vel_limit_ ? VELOCITY_LIMIT : POSITION_LIMIT;
+    LimitType high_type = soft_max_vel ==  max_vel_limit_ ? VELOCITY_LIMIT : POSITION_LIMIT;
+
+    if (limits_.has_acceleration_limits)
+    {
+      const double dt = period.toSec();
+      assert(dt > 0.0);
+
+      // Maximum velocity increment only changes with the period
+      if (period_cache_.update(dt)) {max_acceleration_dt_ = limits_.max_acceleration * dt;}
+
+      // Velocity change over the control period is bounded, but (soft) position and velocity limits take precedence
+      const double vel = jh_.getVelocity();
+      const double min_vel = saturate(vel - max_acceleration_dt_, soft_min_vel, soft_max_vel);
+      const double max_vel = saturate(vel + max_acceleration_dt_, soft_min_vel, soft_max_vel);
+      if (min_vel > soft_min_vel) {low_type  = ACCELERATION_LIMIT;}
+      if (max_vel < soft_max_vel) {high_type = ACCELERATION_LIMIT;}
+      soft_min_vel = min_vel;
+      soft_max_vel = max_vel;
+    }
+
+    // Saturate velocity command according to bounds
+    const double cmd = jh_.getCommand();
+    const double vel_cmd = saturate(cmd,
+                                    soft_min_vel,
+                                    soft_max_vel);
+    jh_.setCommand(vel_cmd);
+
+    recordViolation(cmd < soft_min_vel ? low_type : high_type, cmd, vel_cmd);
+  }
+
+private:
+  static double getMaxVelocityLimit(const JointLimits& limits)
+  {
+    return limits.has_velocity_limits ? limits.max_velocity : std::numeric_limits<double>::max();
+  }
+
+  double max_vel_limit_;
+
+  internal::PeriodCache period_cache_;
+  double max_acceleration_dt_;
+};
+
+/**
+ * \brief A handle used to enforce velocity, acceleration and jerk limits of a velocity-controlled joint.
+ *
+ * Unlike \ref VelocityJointSaturationHandle, bounds are computed from the previously enforced command and the
+ * acceleration it implied, and not from the measured joint velocity. When limits conflict, velocity limits take
+ * precedence over acceleration and jerk limits.
+ *
+ * Copies of a handle share the same command history, so a handle obtained from an interface can be used to
+ * \ref reset the one registered in it.
+ */
+class VelocityJointJerkSaturationHandle : public internal::JointLimitsHandleBase
+{
+public:
+  VelocityJointJerkSaturationHandle() : max_jerk_dt_(0.0) {}
+
+  VelocityJointJerkSaturationHandle(const hardware_interface::JointHandle& jh, const JointLimits& limits)
+    : internal::JointLimitsHandleBase(jh, limits, SoftJointLimits(), 1u << VELOCITY_LIMIT | 1u << JERK_LIMIT),
+      state_(new internal::JerkLimitsState),
+      max_jerk_dt_(0.0)
+  {}
+
+  /**
+   * \brief Forget the command history.
+   *
+   * The next call to \ref enforceLimits will start from the measured joint velocity and zero acceleration. Call this
+   * when commands are not enforced for a while, eg. when switching controllers. Lock-free, can be called from any
+   * thread, through any copy of the handle.
+   */
+  void reset() {state_->reset_requested.store(true, boost::memory_order_release);}
+
+  /**
+   * \brief Enforce joint velocity, acceleration and jerk limits.
+   * \param period Control period.
+   */
+  void enforceLimits(const ros::Duration& period)
+  {
+    assert(state_);
+    const double dt = period.toSec();
+    assert(dt > 0.0);
+
+    using internal::saturate;
+
+    if (updateLimits()) {period_cache_ = internal::PeriodCache();}
+    if (period_cache_.update(dt)) {max_jerk_dt_ = limits_.max_jerk * dt;}
+
+    internal::JerkLimitsState& state = *state_;
+    state.consumeResetRequest();
+    if (!state.initialized)
+    {
+      state.cmd = jh_.getVelocity();
+      state.acc = 0.0;
+      state.initialized = true;
+    }
+
+    // Acceleration bounds
+    double acc_low  = state.acc - max_jerk_dt_;
+    double acc_high = state.acc + max_jerk_dt_;
+    if (limits_.has_acceleration_limits)
+    {
+      acc_low  = saturate(acc_low,  -limits_.max_acceleration, limits_.max_acceleration);
+      acc_high = saturate(acc_high, -limits_.max_acceleration, limits_.max_acceleration);
+    }
+
+    // Velocity bounds
+    const double vel_low  = saturate(state.cmd + acc_low  * dt, -limits_.max_velocity, limits_.max_velocity);
+    const double vel_high = saturate(state.cmd + acc_high * dt, -limits_.max_velocity, limits_.max_velocity);
+
+    // Saturate velocity command according to bounds
+    const double cmd = jh_.getCommand();
+    const double vel_cmd = saturate(cmd,
+                                    vel_low,
+                                    vel_high);
+    jh_.setCommand(vel_cmd);
+
+    const bool   low_bound = cmd < vel_low;
+    const double sign      = low_bound ? -1.0 : 1.0;
+    LimitType type = JERK_LIMIT;
+    if      ((low_bound ? vel_low : vel_high) == sign * limits_.max_velocity) {type = VELOCITY_LIMIT;}
+    else if (limits_.has_acceleration_limits &&
+             (low_bound ? acc_low : acc_high) == sign * limits_.max_acceleration) {type = ACCELERATION_LIMIT;}
+    recordViolation(type, cmd, vel_cmd);
+
+    state.acc = (vel_cmd - state.cmd) / dt;
+    state.cmd = vel_cmd;
+  }
+
+private:
+  boost::shared_ptr<internal::JerkLimitsState> state_;
+
+  internal::PeriodCache period_cache_;
+  double max_jerk_dt_;
+};
+
+/**
+ * \brief A handle used to enforce position, velocity, acceleration and jerk limits of a position-controlled joint.
+ *
+ * Bounds are computed from the previously enforced commands and the velocity and acceleration they implied. When
+ * limits conflict, position limits take precedence over velocity limits, which in turn take precedence over
+ * acceleration and jerk limits.
+ *
+ * Copies of a handle share the same command history, so a handle obtained from an interface can be used to
+ * \ref reset the one registered in it.
+ */
+class PositionJointJerkSaturationHandle : public internal::JointLimitsHandleBase
+{
+public:
+  PositionJointJerkSaturationHandle() : max_jerk_dt_(0.0) {}
+
+  PositionJointJerkSaturationHandle(const hardware_interface::JointHandle& jh, const JointLimits& limits)
+    : internal::JointLimitsHandleBase(jh, limits, SoftJointLimits(), 1u << VELOCITY_LIMIT | 1u << JERK_LIMIT),
+      state_(new internal::JerkLimitsState),
+      max_jerk_dt_(0.0)
+  {}
+
+  /**
+   * \brief Forget the command history.
+   *
+   * The next call to \ref enforceLimits will start from the measured joint position and velocity, and zero
+   * acceleration. Call this when commands are not enforced for a while, eg. when switching controllers. Lock-free,
+   * can be called from any thread, through any copy of the handle.
+   */
+  void reset() {state_->reset_requested.store(true, boost::memory_order_release);}
+
+  /**
+   * \brief Enforce joint position, velocity, acceleration and jerk limits.
+   *
+   * If the joint has no position limits (eg. a continuous joint), only velocity, acceleration and jerk limits will be
+   * enforced. If it also has angle wraparound, the command is taken as an angle, and the enforced command lies in the
+   * revolution closest to the previously enforced command.
+   * \param period Control period.
+   */
+  void enforceLimits(const ros::Duration& period)
+  {
+    assert(state_);
+    const double dt = period.toSec();
+    assert(dt > 0.0);
+
+    using internal::saturate;
+
+    if (updateLimits()) {period_cache_ = internal::PeriodCache();}
+    if (period_cache_.update(dt)) {max_jerk_dt_ = limits_.max_jerk * dt;}
+
+    internal::JerkLimitsState& state = *state_;
+    state.consumeResetRequest();
+    if (!state.initialized)
+    {
+      state.cmd = jh_.getPosition();
+      state.vel = jh_.getVelocity();
+      state.acc = 0.0;
+      state.initialized = true;
+    }
+
+    // Acceleration bounds
+    double acc_low  = state.acc - max_jerk_dt_;
+    double acc_high = state.acc + max_jerk_dt_;
+    if (limits_.has_acceleration_limits)
+    {
+      acc_low  = saturate(acc_low,  -limits_.max_acceleration, limits_.max_acceleration);
+      acc_high = saturate(acc_high, -limits_.max_acceleration, limits_.max_acceleration);
+    }
+
+    // Velocity bounds
+    const double vel_low  = saturate(state.vel + acc_low  * dt, -limits_.max_velocity, limits_.max_velocity);
+    const double vel_high = saturate(state.vel + acc_high * dt, -limits_.max_velocity, limits_.max_velocity);
+
+    // Position bounds
+    double pos_low  = state.cmd + vel_low  * dt;
+    double pos_high = state.cmd + vel_high * dt;
+    if (limits_.has_position_limits)
+    {
+      pos_low  = saturate(pos_low,  limits_.min_position, limits_.max_position);
+      pos_high = saturate(pos_high, limits_.min_position, limits_.max_position);
+    }
+
+    // Saturate position command according to bounds
+    const double cmd = unwrapCommand(jh_.getCommand(), state.cmd);
+    const double pos_cmd = saturate(cmd,
+                                    pos_low,
+                                    pos_high);
+    jh_.setCommand(pos_cmd);
+
+    const bool   low_bound = cmd < pos_low;
+    const double sign      = low_bound ? -1.0 : 1.0;
+    const double pos_bound = low_bound ? pos_low : pos_high;
+    LimitType type = JERK_LIMIT;
+    if (limits_.has_position_limits &&
+        (pos_bound == limits_.min_position || pos_bound == limits_.max_position)) {type = POSITION_LIMIT;}
+    else if ((low_bound ? vel_low : vel_high) == sign * limits_.max_velocity)    {type = VELOCITY_LIMIT;}
+    else if (limits_.has_acceleration_limits &&
+             (low_bound ? acc_low : acc_high) == sign * limits_.max_acceleration) {type = ACCELERATION_LIMIT;}
+    recordViolation(type, cmd, pos_cmd);
+
+    const double vel = (pos_cmd - state.cmd) / dt;
+    state.acc = (vel - state.vel) / dt;
+    state.vel = vel;
+    state.cmd = pos_cmd;
+  }
+
+private:
+  boost::shared_ptr<internal::JerkLimitsState> state_;
+
+  internal::PeriodCache period_cache_;
+  double max_jerk_dt_;
 };
 
 /**
@@ -375,6 +1016,28 @@ public:
     }
   }
 
+  /**
+   * \brief Replace the limits of a managed joint, keeping its current soft limits.
+   *
+   * Not real-time safe, but lock-free with respect to \ref enforceLimits: the new limits are double-buffered and take
+   * effect in the next control cycle, without re-registering the joint's handle.
+   * \throw JointLimitsInterfaceException if the joint is not managed by the interface, or if \e limits lacks a
+   * specification required by its handle.
+   */
+  void setLimits(const std::string& name, const JointLimits& limits)
+  {
+    getHandle(name).setLimits(limits);
+  }
+
+  /**
+   * \brief Replace the limits and soft limits of a managed joint.
+   * \sa setLimits(const std::string&, const JointLimits&)
+   */
+  void setLimits(const std::string& name, const JointLimits& limits, const SoftJointLimits& soft_limits)
+  {
+    getHandle(name).setLimits(limits, soft_limits);
+  }
+
   /** \name Real-Time Safe Functions
    *\{*/
   /** \brief Enforce limits for all managed handles. */
@@ -401,6 +1064,15 @@ class EffortJointSoftLimitsInterface : public JointLimitsInterface<EffortJointSo
 /** Interface for enforcing limits on a velocity-controlled joint through saturation. */
 class VelocityJointSaturationInterface : public JointLimitsInterface<VelocityJointSaturationHandle> {};
 
+/** Interface for enforcing limits on a velocity-controlled joint with soft position limits. */
+class VelocityJointSoftLimitsInterface : public JointLimitsInterface<VelocityJointSoftLimitsHandle> {};
+
+/** Interface for enforcing limits on a velocity-controlled joint with jerk limits. */
+class VelocityJointJerkSaturationInterface : public JointLimitsInterface<VelocityJointJerkSaturationHandle> {};
+
+/** Interface for enforcing limits on a position-controlled joint with jerk limits. */
+class PositionJointJerkSaturationInterface : public JointLimitsInterface<PositionJointJerkSaturationHandle> {};
+
 }
 
 #endif
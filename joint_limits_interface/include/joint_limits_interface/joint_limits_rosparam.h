@@ -30,76 +30,64 @@
 #ifndef JOINT_LIMITS_INTERFACE_JOINT_LIMITS_ROSPARAM_H
 #define JOINT_LIMITS_INTERFACE_JOINT_LIMITS_ROSPARAM_H
 
+#include <map>
 #include <string>
 
 #include <ros/ros.h>
+#include <XmlRpcValue.h>
 #include <joint_limits_interface/joint_limits.h>
 
 namespace joint_limits_interface
 {
 
+namespace internal
+{
+
+/** \brief Get a boolean member of an XML-RPC struct. \return True if the member exists and has the right type. */
+inline bool getMember(XmlRpc::XmlRpcValue& spec, const std::string& name, bool& value)
+{
+  if (!spec.hasMember(name) || spec[name].getType() != XmlRpc::XmlRpcValue::TypeBoolean) {return false;}
+  value = static_cast<bool>(spec[name]);
+  return true;
+}
+
 /**
- * \brief Populate a JointLimits instance from the ROS parameter server.
- *
- * It is assumed that the following parameter structure is followed on the provided NodeHandle. Unspecified parameters
- * are simply not added to the joint limits specification.
- * \code
- * joint_limits:
- *   foo_joint:
- *     has_position_limits: true
- *     min_position: 0.0
- *     max_position: 1.0
- *     has_velocity_limits: true
- *     max_velocity: 2.0
- *     has_acceleration_limits: true
- *     max_acceleration: 5.0
- *     has_jerk_limits: true
- *     max_jerk: 100.0
- *     has_effort_limits: true
- *     max_effort: 20.0
- *   bar_joint:
- *     has_position_limits: false # Continuous joint
- *     has_velocity_limits: true
- *     max_velocity: 4.0
- * \endcode
- *
- * This specification is similar to the one used by <a href="http://moveit.ros.org/wiki/MoveIt!">MoveIt!</a>,
- * but additionally supports jerk and effort limits.
- *
- * \param[in] joint_name Name of joint whose limits are to be fetched.
- * \param[in] nh NodeHandle where the joint limits are specified.
- * \param[out] limits Where joint limit data gets written into. Limits specified in the parameter server will overwrite
- * existing values. Values in \p limits not specified in the parameter server remain unchanged.
- * \return True if a limits specification is found (ie. the \p joint_limits/joint_name parameter exists in \p nh), false otherwise.
+ * \brief Get a floating-point member of an XML-RPC struct. As with ros::NodeHandle::getParam, integers are also
+ * accepted.
+ * \return True if the member exists and has the right type.
  */
-bool getJointLimits(const std::string& joint_name, const ros::NodeHandle& nh, JointLimits& limits)
+inline bool getMember(XmlRpc::XmlRpcValue& spec, const std::string& name, double& value)
 {
-  // Node handle scoped where the joint limits are defined
-  ros::NodeHandle limits_nh;
-  try
+  if (!spec.hasMember(name)) {return false;}
+  XmlRpc::XmlRpcValue& member = spec[name];
+  if (member.getType() == XmlRpc::XmlRpcValue::TypeDouble)
   {
-    const std::string limits_namespace = "joint_limits/" + joint_name;
-    if (!nh.hasParam(limits_namespace))
-    {
-      ROS_DEBUG_STREAM("No joint limits specification found for joint '" << joint_name <<
-                       "' in the parameter server (namespace " << nh.getNamespace() + "/" + limits_namespace << ").");
-      return false;
-    }
-    limits_nh = ros::NodeHandle(nh, limits_namespace);
+    value = static_cast<double>(member);
+    return true;
   }
-  catch(const ros::InvalidNameException& ex)
+  if (member.getType() == XmlRpc::XmlRpcValue::TypeInt)
   {
-    ROS_ERROR_STREAM(ex.what());
-    return false;
+    value = static_cast<int>(member);
+    return true;
   }
+  return false;
+}
 
+/**
+ * \brief Populate a JointLimits instance from the limits specification of a single joint, already fetched from the
+ * parameter server.
+ *
+ * Values not present in \p spec leave \p limits unchanged.
+ */
+inline void parseJointLimits(XmlRpc::XmlRpcValue& spec, JointLimits& limits)
+{
   // Position limits
   bool has_position_limits = false;
-  if(limits_nh.getParam("has_position_limits", has_position_limits))
+  if(getMember(spec, "has_position_limits", has_position_limits))
   {
     if (!has_position_limits) {limits.has_position_limits = false;}
     double min_pos, max_pos;
-    if (has_position_limits && limits_nh.getParam("min_position", min_pos) && limits_nh.getParam("max_position", max_pos))
+    if (has_position_limits && getMember(spec, "min_position", min_pos) && getMember(spec, "max_position", max_pos))
     {
       limits.has_position_limits = true;
       limits.min_position = min_pos;
@@ -107,7 +95,7 @@ bool getJointLimits(const std::string& joint_name, const ros::NodeHandle& nh, Jo
     }
 
     bool angle_wraparound;
-    if (!has_position_limits && limits_nh.getParam("angle_wraparound", angle_wraparound))
+    if (!has_position_limits && getMember(spec, "angle_wraparound", angle_wraparound))
     {
       limits.angle_wraparound = angle_wraparound;
     }
@@ -115,11 +103,11 @@ bool getJointLimits(const std::string& joint_name, const ros::NodeHandle& nh, Jo
 
   // Velocity limits
   bool has_velocity_limits = false;
-  if(limits_nh.getParam("has_velocity_limits", has_velocity_limits))
+  if(getMember(spec, "has_velocity_limits", has_velocity_limits))
   {
     if (!has_velocity_limits) {limits.has_velocity_limits = false;}
     double max_vel;
-    if (has_velocity_limits && limits_nh.getParam("max_velocity", max_vel))
+    if (has_velocity_limits && getMember(spec, "max_velocity", max_vel))
     {
       limits.has_velocity_limits = true;
       limits.max_velocity = max_vel;
@@ -128,11 +116,11 @@ bool getJointLimits(const std::string& joint_name, const ros::NodeHandle& nh, Jo
 
   // Acceleration limits
   bool has_acceleration_limits = false;
-  if(limits_nh.getParam("has_acceleration_limits", has_acceleration_limits))
+  if(getMember(spec, "has_acceleration_limits", has_acceleration_limits))
   {
     if (!has_acceleration_limits) {limits.has_acceleration_limits = false;}
     double max_acc;
-    if (has_acceleration_limits && limits_nh.getParam("max_acceleration", max_acc))
+    if (has_acceleration_limits && getMember(spec, "max_acceleration", max_acc))
     {
       limits.has_acceleration_limits = true;
       limits.max_acceleration = max_acc;
@@ -141,11 +129,11 @@ bool getJointLimits(const std::string& joint_name, const ros::NodeHandle& nh, Jo
 
   // Jerk limits
   bool has_jerk_limits = false;
-  if(limits_nh.getParam("has_jerk_limits", has_jerk_limits))
+  if(getMember(spec, "has_jerk_limits", has_jerk_limits))
   {
     if (!has_jerk_limits) {limits.has_jerk_limits = false;}
     double max_jerk;
-    if (has_jerk_limits && limits_nh.getParam("max_jerk", max_jerk))
+    if (has_jerk_limits && getMember(spec, "max_jerk", max_jerk))
     {
       limits.has_jerk_limits = true;
       limits.max_jerk = max_jerk;
@@ -154,17 +142,106 @@ bool getJointLimits(const std::string& joint_name, const ros::NodeHandle& nh, Jo
 
   // Effort limits
   bool has_effort_limits = false;
-  if(limits_nh.getParam("has_effort_limits", has_effort_limits))
+  if(getMember(spec, "has_effort_limits", has_effort_limits))
   {
     if (!has_effort_limits) {limits.has_effort_limits = false;}
     double max_effort;
-    if (has_effort_limits && limits_nh.getParam("max_effort", max_effort))
+    if (has_effort_limits && getMember(spec, "max_effort", max_effort))
     {
       limits.has_effort_limits = true;
       limits.max_effort = max_effort;
     }
   }
+}
+
+} // namespace internal
+
+/**
+ * \brief Populate a JointLimits instance from the ROS parameter server.
+ *
+ * It is assumed that the following parameter structure is followed on the provided NodeHandle. Unspecified parameters
+ * are simply not added to the joint limits specification.
+ * \code
+ * joint_limits:
+ *   foo_joint:
+ *     has_position_limits: true
+ *     min_position: 0.0
+ *     max_position: 1.0
+ *     has_velocity_limits: true
+ *     max_velocity: 2.0
+ *     has_acceleration_limits: true
+ *     max_acceleration: 5.0
+ *     has_jerk_limits: true
+ *     max_jerk: 100.0
+ *     has_effort_limits: true
+ *     max_effort: 20.0
+ *   bar_joint:
+ *     has_position_limits: false # Continuous joint
+ *     has_velocity_limits: true
+ *     max_velocity: 4.0
+ * \endcode
+ *
+ * This specification is similar to the one used by <a href="http://moveit.ros.org/wiki/MoveIt!">MoveIt!</a>,
+ * but additionally supports jerk and effort limits.
+ *
+ * \param[in] joint_name Name of joint whose limits are to be fetched.
+ * \param[in] nh NodeHandle where the joint limits are specified.
+ * \param[out] limits Where joint limit data gets written into. Limits specified in the parameter server will overwrite
+ * existing values. Values in \p limits not specified in the parameter server remain unchanged.
+ * \return True if a limits specification is found (ie. the \p joint_limits/joint_name parameter exists in \p nh), false otherwise.
+ */
+bool getJointLimits(const std::string& joint_name, const ros::NodeHandle& nh, JointLimits& limits)
+{
+  // Fetch the whole joint limits specification at once, instead of querying the parameter server once per value
+  XmlRpc::XmlRpcValue limits_spec;
+  try
+  {
+    const std::string limits_namespace = "joint_limits/" + joint_name;
+    if (!nh.getParam(limits_namespace, limits_spec))
+    {
+      ROS_DEBUG_STREAM("No joint limits specification found for joint '" << joint_name <<
+                       "' in the parameter server (namespace " << nh.getNamespace() + "/" + limits_namespace << ").");
+      return false;
+    }
+  }
+  catch(const ros::InvalidNameException& ex)
+  {
+    ROS_ERROR_STREAM(ex.what());
+    return false;
+  }
 
+  internal::parseJointLimits(limits_spec, limits);
+  return true;
+}
+
+/**
+ * \brief Populate the JointLimits of all joints specified in the ROS parameter server.
+ *
+ * The whole \p joint_limits namespace is fetched in a single parameter server query and parsed locally, which is
+ * considerably faster than calling \ref getJointLimits(const std::string&, const ros::NodeHandle&, JointLimits&)
+ * "getJointLimits" once per joint when there are many joints. The expected parameter structure is the same.
+ *
+ * \param[in] nh NodeHandle where the joint limits are specified.
+ * \param[out] limits Joint limits indexed by joint name. For each joint in the parameter server, limits specified
+ * there will overwrite existing values of the corresponding map entry, which is created if it does not exist. Values
+ * not specified in the parameter server, as well as entries of joints not in the parameter server, remain unchanged.
+ * \return True if a limits specification is found (ie. the \p joint_limits parameter exists in \p nh and is a
+ * dictionary), false otherwise.
+ */
+inline bool getAllJointLimits(const ros::NodeHandle& nh, std::map<std::string, JointLimits>& limits)
+{
+  XmlRpc::XmlRpcValue limits_spec;
+  if (!nh.getParam("joint_limits", limits_spec) || limits_spec.getType() != XmlRpc::XmlRpcValue::TypeStruct)
+  {
+    ROS_DEBUG_STREAM("No joint limits specification found in the parameter server (namespace " <<
+                     nh.getNamespace() + "/joint_limits).");
+    return false;
+  }
+
+  for (XmlRpc::XmlRpcValue::iterator it = limits_spec.begin(); it != limits_spec.end(); ++it)
+  {
+    internal::parseJointLimits(it->second, limits[it->first]);
+  }
   return true;
 }
 
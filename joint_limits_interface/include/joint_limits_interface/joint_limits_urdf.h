@@ -30,12 +30,24 @@
 #ifndef JOINT_LIMITS_INTERFACE_JOINT_LIMITS_URDF_H
 #define JOINT_LIMITS_INTERFACE_JOINT_LIMITS_URDF_H
 
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
 #include <ros/common.h>
 #if ROS_VERSION_MINIMUM(1, 9, 0) // TODO: Deprecate this conditional when Fuerte support is EOL'd
   #include <urdf_model/joint.h> // Fuerte.
+  #include <urdf_model/model.h>
 #else
   #include <urdf_interface/joint.h> // Groovy and later
+  #include <urdf_interface/model.h>
 #endif
+#include <urdf_parser/urdf_parser.h>
 #include <joint_limits_interface/joint_limits.h>
 
 namespace joint_limits_interface
@@ -99,6 +111,152 @@ bool getSoftJointLimits(boost::shared_ptr<const urdf::Joint> urdf_joint, SoftJoi
   return true;
 }
 
+/**
+ * \brief Joint limits of all the joints of a robot model.
+ *
+ * The limits specification of every joint is extracted once on construction, with the same semantics as
+ * \ref getJointLimits and \ref getSoftJointLimits applied to default-constructed limits, and stored in contiguous
+ * arrays. Joints are indexed in ascending name order, so the \e i-th element of every array refers to the joint
+ * named \c getNames()[i].
+ *
+ * Tables are immutable once built, hence can be shared by all users of the same robot model without further
+ * synchronization. See \ref getSharedJointLimitsTable.
+ */
+class JointLimitsTable
+{
+public:
+  JointLimitsTable() {}
+
+  /**
+   * \param model Parsed robot model. Joints without a limits (resp. safety) specification are part of the table, but
+   * are flagged as such by \ref hasJointLimits (resp. \ref hasSoftJointLimits).
+   */
+  explicit JointLimitsTable(const urdf::ModelInterface& model)
+  {
+    typedef std::map<std::string, boost::shared_ptr<urdf::Joint> > UrdfJointMap;
+
+    const std::size_t size = model.joints_.size();
+    names_.reserve(size);
+    limits_.reserve(size);
+    soft_limits_.reserve(size);
+    has_limits_.reserve(size);
+    has_soft_limits_.reserve(size);
+
+    // Map is sorted by joint name, which is what getIndex relies upon
+    for (UrdfJointMap::const_iterator it = model.joints_.begin(); it != model.joints_.end(); ++it)
+    {
+      JointLimits limits;
+      SoftJointLimits soft_limits;
+      has_limits_.push_back(joint_limits_interface::getJointLimits(it->second, limits));
+      has_soft_limits_.push_back(joint_limits_interface::getSoftJointLimits(it->second, soft_limits));
+
+      names_.push_back(it->first);
+      limits_.push_back(limits);
+      soft_limits_.push_back(soft_limits);
+    }
+  }
+
+  /** \return Number of joints in the table. */
+  std::size_t size() const {return names_.size();}
+
+  /** \return Joint names, sorted in ascending order. */
+  const std::vector<std::string>& getNames() const {return names_;}
+
+  /** \return Joint limits, in the same order as \ref getNames. */
+  const std::vector<JointLimits>& getJointLimits() const {return limits_;}
+
+  /** \return Soft joint limits, in the same order as \ref getNames. */
+  const std::vector<SoftJointLimits>& getSoftJointLimits() const {return soft_limits_;}
+
+  /** \return True if the joint at \e index has a valid limits specification. */
+  bool hasJointLimits(std::size_t index) const {return has_limits_[index];}
+
+  /** \return True if the joint at \e index has a valid soft limits specification. */
+  bool hasSoftJointLimits(std::size_t index) const {return has_soft_limits_[index];}
+
+  /**
+   * \brief Find the index of a joint in the table.
+   * \param[in] name Joint name.
+   * \param[out] index Position of joint \e name in the table arrays.
+   * \return True if the table contains joint \e name, false otherwise.
+   */
+  bool getIndex(const std::string& name, std::size_t& index) const
+  {
+    std::vector<std::string>::const_iterator it = std::lower_bound(names_.begin(), names_.end(), name);
+    if (it == names_.end() || *it != name) {return false;}
+    index = it - names_.begin();
+    return true;
+  }
+
+  /**
+   * \param name Joint name.
+   * \return Limits of joint \e name, or a null pointer if the joint does not exist or has no limits specification.
+   */
+  const JointLimits* findJointLimits(const std::string& name) const
+  {
+    std::size_t index;
+    return (getIndex(name, index) && has_limits_[index]) ? &limits_[index] : 0;
+  }
+
+  /**
+   * \param name Joint name.
+   * \return Soft limits of joint \e name, or a null pointer if the joint does not exist or has no soft limits
+   * specification.
+   */
+  const SoftJointLimits* findSoftJointLimits(const std::string& name) const
+  {
+    std::size_t index;
+    return (getIndex(name, index) && has_soft_limits_[index]) ? &soft_limits_[index] : 0;
+  }
+
+private:
+  std::vector<std::string>     names_;
+  std::vector<JointLimits>     limits_;
+  std::vector<SoftJointLimits> soft_limits_;
+  std::vector<bool>            has_limits_;
+  std::vector<bool>            has_soft_limits_;
+};
+
+/**
+ * \brief Get the joint limits table of a robot description, shared with all other users in the process.
+ *
+ * The robot description is parsed and its limits extracted only if no other user in the process currently holds the
+ * table of an identical description, so that multiple controllers of the same robot pay for the conversion once.
+ * The table is released when its last user drops it.
+ *
+ * \note This function is thread-safe, but not real-time safe.
+ * \param robot_description Robot description XML string, as found in the \c robot_description parameter.
+ * \return Joint limits table, or a null pointer if \e robot_description could not be parsed.
+ */
+inline boost::shared_ptr<const JointLimitsTable> getSharedJointLimitsTable(const std::string& robot_description)
+{
+  typedef std::map<std::string, boost::weak_ptr<const JointLimitsTable> > TableMap;
+
+  static boost::mutex mutex;
+  static TableMap tables;
+
+  boost::mutex::scoped_lock lock(mutex);
+
+  // Forget tables no longer in use
+  for (TableMap::iterator it = tables.begin(); it != tables.end();)
+  {
+    if (it->second.expired()) {tables.erase(it++);}
+    else                      {++it;}
+  }
+
+  TableMap::iterator it = tables.find(robot_description);
+  boost::shared_ptr<const JointLimitsTable> table;
+  if (it != tables.end()) {table = it->second.lock();}
+  if (table) {return table;}
+
+  boost::shared_ptr<urdf::ModelInterface> model = urdf::parseURDF(robot_description);
+  if (!model) {return table;}
+
+  table.reset(new JointLimitsTable(*model));
+  tables[robot_description] = table;
+  return table;
+}
+
 }
 
 #endif
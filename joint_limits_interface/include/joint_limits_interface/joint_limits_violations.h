@@ -0,0 +1,108 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013, PAL Robotics S.L.
+// Copyright (c) 2008, Willow Garage, Inc.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of hiDOF, Inc. nor the names of its
+//     contributors may be used to endorse or promote products derived from
+//     this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef JOINT_LIMITS_INTERFACE_JOINT_LIMITS_VIOLATIONS_H
+#define JOINT_LIMITS_INTERFACE_JOINT_LIMITS_VIOLATIONS_H
+
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace joint_limits_interface
+{
+
+/** \brief Kinds of joint limits whose violations are accounted for. */
+enum LimitType
+{
+  POSITION_LIMIT,
+  VELOCITY_LIMIT,
+  ACCELERATION_LIMIT,
+  JERK_LIMIT,
+  EFFORT_LIMIT,
+  LIMIT_TYPE_COUNT
+};
+
+/** \return Human-readable name of a limit type, eg. \c "position". */
+inline const char* getLimitTypeName(LimitType type)
+{
+  static const char* names[LIMIT_TYPE_COUNT] = {"position", "velocity", "acceleration", "jerk", "effort"};
+  return type < LIMIT_TYPE_COUNT ? names[type] : "unknown";
+}
+
+/**
+ * \brief Counters of the commands of a joint that had to be modified to honor its limits.
+ *
+ * For each limit type, keeps how many times a command was clamped because of it, and the largest correction applied.
+ * Counters are updated from the real-time thread and can be read concurrently from any other thread without locking.
+ */
+class JointLimitsViolations : private boost::noncopyable
+{
+public:
+  JointLimitsViolations() {reset();}
+
+  /** \name Real-Time Safe Functions
+   *\{*/
+  /**
+   * \brief Record a command clamp.
+   * \param type Limit type that caused the clamp.
+   * \param magnitude Absolute difference between the requested and enforced commands.
+   */
+  void record(LimitType type, double magnitude)
+  {
+    counts_[type].fetch_add(1, boost::memory_order_relaxed);
+
+    double max_magnitude = max_magnitudes_[type].load(boost::memory_order_relaxed);
+    while (magnitude > max_magnitude &&
+           !max_magnitudes_[type].compare_exchange_weak(max_magnitude, magnitude, boost::memory_order_relaxed)) {}
+  }
+
+  /** \return Number of clamps caused by limits of type \e type. */
+  boost::uint64_t getCount(LimitType type) const {return counts_[type].load(boost::memory_order_relaxed);}
+
+  /** \return Largest correction applied because of limits of type \e type. */
+  double getMaxMagnitude(LimitType type) const {return max_magnitudes_[type].load(boost::memory_order_relaxed);}
+  /*\}*/
+
+  /** \brief Zero all counters. Updates racing with a reset may be lost. */
+  void reset()
+  {
+    for (unsigned int i = 0; i < LIMIT_TYPE_COUNT; ++i)
+    {
+      counts_[i].store(0, boost::memory_order_relaxed);
+      max_magnitudes_[i].store(0.0, boost::memory_order_relaxed);
+    }
+  }
+
+private:
+  boost::atomic<boost::uint64_t> counts_[LIMIT_TYPE_COUNT];
+  boost::atomic<double>          max_magnitudes_[LIMIT_TYPE_COUNT];
+};
+
+}
+
+#endif
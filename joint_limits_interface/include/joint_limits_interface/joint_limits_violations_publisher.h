@@ -0,0 +1,215 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013, PAL Robotics S.L.
+// Copyright (c) 2008, Willow Garage, Inc.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of hiDOF, Inc. nor the names of its
+//     contributors may be used to endorse or promote products derived from
+//     this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef JOINT_LIMITS_INTERFACE_JOINT_LIMITS_VIOLATIONS_PUBLISHER_H
+#define JOINT_LIMITS_INTERFACE_JOINT_LIMITS_VIOLATIONS_PUBLISHER_H
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <errno.h>
+#include <semaphore.h>
+
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <ros/node_handle.h>
+#include <ros/publisher.h>
+#include <diagnostic_msgs/DiagnosticArray.h>
+
+#include <joint_limits_interface/joint_limits_interface.h>
+#include <joint_limits_interface/joint_limits_violations.h>
+
+namespace joint_limits_interface
+{
+
+/**
+ * \brief Periodically publish the limit violation counters of a set of joints as diagnostics.
+ *
+ * The control loop only calls \ref update, which wakes up a separate non real-time thread once every \e decimation
+ * calls. Counters are read, and the message is built and published from that thread, which otherwise sleeps.
+ *
+ * One diagnostic status is published per joint, with level \c WARN if any of its commands was clamped since the
+ * previous message, and \c OK otherwise.
+ */
+class JointLimitsViolationsPublisher : private boost::noncopyable
+{
+public:
+  /**
+   * \param nh Node handle in whose namespace the \c joint_limits_violations topic is advertised.
+   * \param decimation Publish once every \e decimation calls to \ref update.
+   */
+  JointLimitsViolationsPublisher(const ros::NodeHandle& nh, unsigned int decimation)
+    : decimation_(std::max(decimation, 1u)),
+      cycles_(0),
+      publish_pending_(false),
+      keep_running_(true)
+  {
+    sem_init(&semaphore_, 0, 0);
+    ros::NodeHandle pub_nh(nh);
+    pub_ = pub_nh.advertise<diagnostic_msgs::DiagnosticArray>("joint_limits_violations", 1);
+    thread_ = boost::thread(&JointLimitsViolationsPublisher::publishingLoop, this);
+  }
+
+  ~JointLimitsViolationsPublisher()
+  {
+    keep_running_.store(false, boost::memory_order_release);
+    sem_post(&semaphore_);
+    thread_.join();
+    sem_destroy(&semaphore_);
+  }
+
+  /** \name Non Real-Time Safe Functions
+   *\{*/
+  /** \brief Add a joint whose violation counters will be published. */
+  template <class HandleType>
+  void addHandle(const HandleType& handle)
+  {
+    if (!handle.getViolations()) {return;}
+
+    boost::mutex::scoped_lock lock(mutex_);
+    names_.push_back(handle.getName());
+    violations_.push_back(handle.getViolations());
+    last_counts_.resize(violations_.size() * LIMIT_TYPE_COUNT, 0);
+  }
+
+  /** \brief Add all joints managed by a limits interface. */
+  template <class HandleType>
+  void addInterface(JointLimitsInterface<HandleType>& iface)
+  {
+    const std::vector<std::string> names = iface.getNames();
+    for (std::vector<std::string>::const_iterator it = names.begin(); it != names.end(); ++it)
+    {
+      addHandle(iface.getHandle(*it));
+    }
+  }
+  /*\}*/
+
+  /** \name Real-Time Safe Functions
+   *\{*/
+  /** \brief Count a control cycle, and request a publication every \e decimation cycles. */
+  void update()
+  {
+    if (++cycles_ < decimation_)
+    {
+      return;
+    }
+    cycles_ = 0;
+
+    // Only wake up the publishing thread if it has caught up with the previous request
+    if (!publish_pending_.exchange(true, boost::memory_order_acq_rel))
+    {
+      sem_post(&semaphore_);
+    }
+  }
+  /*\}*/
+
+private:
+  unsigned int decimation_;
+  unsigned int cycles_;
+  boost::atomic<bool> publish_pending_;
+  boost::atomic<bool> keep_running_;
+  sem_t semaphore_;
+
+  ros::Publisher pub_;
+  boost::thread thread_;
+
+  boost::mutex mutex_;
+  std::vector<std::string> names_;
+  std::vector<boost::shared_ptr<const JointLimitsViolations> > violations_;
+  std::vector<boost::uint64_t> last_counts_;
+
+  void publishingLoop()
+  {
+    while (true)
+    {
+      while (sem_wait(&semaphore_) != 0 && errno == EINTR) {}
+
+      if (!keep_running_.load(boost::memory_order_acquire))
+      {
+        return;
+      }
+      if (publish_pending_.exchange(false, boost::memory_order_acq_rel))
+      {
+        publish();
+      }
+    }
+  }
+
+  void publish()
+  {
+    diagnostic_msgs::DiagnosticArray msg;
+    msg.header.stamp = ros::Time::now();
+
+    boost::mutex::scoped_lock lock(mutex_);
+    msg.status.resize(names_.size());
+    for (std::size_t i = 0; i < names_.size(); ++i)
+    {
+      diagnostic_msgs::DiagnosticStatus& status = msg.status[i];
+      status.name = names_[i];
+      status.level = diagnostic_msgs::DiagnosticStatus::OK;
+
+      for (unsigned int j = 0; j < LIMIT_TYPE_COUNT; ++j)
+      {
+        const LimitType type = static_cast<LimitType>(j);
+        const boost::uint64_t count = violations_[i]->getCount(type);
+
+        boost::uint64_t& last_count = last_counts_[i * LIMIT_TYPE_COUNT + j];
+        if (count != last_count) {status.level = diagnostic_msgs::DiagnosticStatus::WARN;}
+        last_count = count;
+
+        std::ostringstream count_str;
+        count_str << count;
+        std::ostringstream magnitude_str;
+        magnitude_str << violations_[i]->getMaxMagnitude(type);
+
+        diagnostic_msgs::KeyValue kv;
+        kv.key = std::string(getLimitTypeName(type)) + " violations";
+        kv.value = count_str.str();
+        status.values.push_back(kv);
+        kv.key = std::string(getLimitTypeName(type)) + " max correction";
+        kv.value = magnitude_str.str();
+        status.values.push_back(kv);
+      }
+
+      status.message = status.level == diagnostic_msgs::DiagnosticStatus::OK ? "Commands within limits"
+                                                                              : "Commands clamped to honor limits";
+    }
+
+    pub_.publish(msg);
+  }
+};
+
+}
+
+#endif
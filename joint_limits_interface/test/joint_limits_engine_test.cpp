@@ -0,0 +1,231 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013, PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of hiDOF, Inc. nor the names of its
+//     contributors may be used to endorse or promote products derived from
+//     this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//////////////////////////////////////////////////////////////////////////////
+
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <joint_limits_interface/joint_limits_engine.h>
+
+using std::string;
+using std::vector;
+using namespace hardware_interface;
+using namespace joint_limits_interface;
+
+// Floating-point value comparison threshold
+const double EPS = 1e-12;
+
+/**
+ * Two identical sets of joints, one driven through per-joint handles and the other through an engine. Joints cover
+ * all combinations of position and acceleration limits being present. Joints without position limits wrap around.
+ */
+class JointLimitsEngineTest : public ::testing::Test
+{
+public:
+  JointLimitsEngineTest()
+    : n(4),
+      period(0.1),
+      pos(2 * n, 0.0), vel(2 * n, 0.0), eff(2 * n, 0.0), cmd(2 * n, 0.0)
+  {
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      JointLimits l;
+      l.has_position_limits = (i % 2 == 0);
+      l.angle_wraparound = !l.has_position_limits;
+      l.min_position = -1.0;
+      l.max_position =  1.0;
+      l.has_velocity_limits = true;
+      l.max_velocity = 2.0;
+      l.has_acceleration_limits = (i / 2 == 0);
+      l.max_acceleration = 5.0;
+      l.has_effort_limits = true;
+      l.max_effort = 8.0;
+      limits.push_back(l);
+
+      SoftJointLimits s;
+      s.min_position = -0.8;
+      s.max_position =  0.8;
+      s.k_position = 20.0;
+      s.k_velocity = 40.0;
+      soft_limits.push_back(s);
+
+      const string name = "joint" + string(1, '0' + i);
+      handle_jh.push_back(JointHandle(JointStateHandle(name, &pos[i],     &vel[i],     &eff[i]),     &cmd[i]));
+      engine_jh.push_back(JointHandle(JointStateHandle(name, &pos[n + i], &vel[n + i], &eff[n + i]), &cmd[n + i]));
+    }
+  }
+
+  /** Set the same state and command on both sets of joints. */
+  void setState(double p, double v, double c)
+  {
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      // Spread values a bit so that not all joints see the same input
+      const double offset = 0.05 * i;
+      pos[i] = pos[n + i] = p + offset;
+      vel[i] = vel[n + i] = v - offset;
+      cmd[i] = cmd[n + i] = c + offset;
+    }
+  }
+
+  void expectSameCommands()
+  {
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      EXPECT_NEAR(cmd[i], cmd[n + i], EPS) << "joint " << i;
+    }
+  }
+
+  /** Run both limits enforcement paths over a grid of states and commands. */
+  template <class Handle, class Engine>
+  void checkSweep(vector<Handle>& handles, Engine& engine)
+  {
+    for (double p = -1.5; p <= 1.5; p += 0.25)
+    {
+      for (double v = -3.0; v <= 3.0; v += 0.5)
+      {
+        for (double c = -10.0; c <= 10.0; c += 0.75)
+        {
+          setState(p, v, c);
+          for (std::size_t i = 0; i < handles.size(); ++i) {handles[i].enforceLimits(period);}
+          engine.enforceLimits(period);
+          expectSameCommands();
+        }
+      }
+    }
+  }
+
+protected:
+  std::size_t n;
+  ros::Duration period;
+  vector<double> pos, vel, eff, cmd;
+  vector<JointLimits> limits;
+  vector<SoftJointLimits> soft_limits;
+  vector<JointHandle> handle_jh;
+  vector<JointHandle> engine_jh;
+};
+
+TEST_F(JointLimitsEngineTest, Registration)
+{
+  VelocityJointSaturationEngine engine;
+  EXPECT_EQ(0, engine.size());
+
+  engine.registerJoint(engine_jh[0], limits[0]);
+  engine.registerJoint(engine_jh[1], limits[1]);
+  ASSERT_EQ(2, engine.size());
+  EXPECT_EQ("joint0", engine.getNames()[0]);
+  EXPECT_EQ("joint1", engine.getNames()[1]);
+
+  // Missing mandatory limits
+  JointLimits bad_limits;
+  EXPECT_THROW(engine.registerJoint(engine_jh[2], bad_limits), JointLimitsInterfaceException);
+
+  PositionJointSoftLimitsEngine pos_engine;
+  EXPECT_THROW(pos_engine.registerJoint(engine_jh[2], bad_limits, soft_limits[2]), JointLimitsInterfaceException);
+
+  EffortJointSoftLimitsEngine eff_engine;
+  bad_limits.has_velocity_limits = true;
+  EXPECT_THROW(eff_engine.registerJoint(engine_jh[2], bad_limits, soft_limits[2]), JointLimitsInterfaceException);
+
+  // Empty engine is a no-op
+  EffortJointSaturationEngine empty_engine;
+  empty_engine.enforceLimits(period);
+}
+
+TEST_F(JointLimitsEngineTest, PositionJointSoftLimits)
+{
+  vector<PositionJointSoftLimitsHandle> handles;
+  PositionJointSoftLimitsEngine engine;
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    handles.push_back(PositionJointSoftLimitsHandle(handle_jh[i], limits[i], soft_limits[i]));
+    engine.registerJoint(engine_jh[i], limits[i], soft_limits[i]);
+  }
+  checkSweep(handles, engine);
+}
+
+TEST_F(JointLimitsEngineTest, EffortJointSaturation)
+{
+  // Also cover missing effort and velocity limits
+  limits[1].has_effort_limits   = false;
+  limits[3].has_velocity_limits = false;
+
+  vector<EffortJointSaturationHandle> handles;
+  EffortJointSaturationEngine engine;
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    handles.push_back(EffortJointSaturationHandle(handle_jh[i], limits[i]));
+    engine.registerJoint(engine_jh[i], limits[i]);
+  }
+  checkSweep(handles, engine);
+}
+
+TEST_F(JointLimitsEngineTest, EffortJointSoftLimits)
+{
+  vector<EffortJointSoftLimitsHandle> handles;
+  EffortJointSoftLimitsEngine engine;
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    handles.push_back(EffortJointSoftLimitsHandle(handle_jh[i], limits[i], soft_limits[i]));
+    engine.registerJoint(engine_jh[i], limits[i], soft_limits[i]);
+  }
+  checkSweep(handles, engine);
+}
+
+TEST_F(JointLimitsEngineTest, VelocityJointSaturation)
+{
+  vector<VelocityJointSaturationHandle> handles;
+  VelocityJointSaturationEngine engine;
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    handles.push_back(VelocityJointSaturationHandle(handle_jh[i], limits[i]));
+    engine.registerJoint(engine_jh[i], limits[i]);
+  }
+  checkSweep(handles, engine);
+}
+
+TEST_F(JointLimitsEngineTest, VelocityJointSoftLimits)
+{
+  // Also cover missing velocity limits
+  limits[3].has_velocity_limits = false;
+
+  vector<VelocityJointSoftLimitsHandle> handles;
+  VelocityJointSoftLimitsEngine engine;
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    handles.push_back(VelocityJointSoftLimitsHandle(handle_jh[i], limits[i], soft_limits[i]));
+    engine.registerJoint(engine_jh[i], limits[i], soft_limits[i]);
+  }
+  checkSweep(handles, engine);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
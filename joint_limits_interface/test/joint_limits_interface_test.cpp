@@ -65,6 +65,20 @@ TEST(SaturateTest, Saturate)
   EXPECT_NEAR(max, saturate(val, min, max), EPS);
 }
 
+TEST(AngleWraparoundTest, WrapAngle)
+{
+  EXPECT_NEAR( 0.0,       wrapAngle(0.0),                EPS);
+  EXPECT_NEAR( 1.0,       wrapAngle(1.0),                EPS);
+  EXPECT_NEAR(-1.0,       wrapAngle(-1.0),               EPS);
+  EXPECT_NEAR( 1.0,       wrapAngle(1.0 + 2.0 * M_PI),   EPS);
+  EXPECT_NEAR(-1.0,       wrapAngle(-1.0 - 4.0 * M_PI),  EPS);
+  EXPECT_NEAR(-M_PI,      wrapAngle(M_PI),               EPS);
+  EXPECT_NEAR(-M_PI,      wrapAngle(-M_PI),              EPS);
+
+  EXPECT_NEAR( 0.2, shortestAngularDistance(M_PI - 0.1, -M_PI + 0.1), EPS);
+  EXPECT_NEAR(-0.2, shortestAngularDistance(-M_PI + 0.1, M_PI - 0.1), EPS);
+  EXPECT_NEAR( 0.5, shortestAngularDistance(0.0, 0.5 + 6.0 * M_PI),   EPS);
+}
 
 class JointLimitsTest
 {
@@ -109,12 +123,17 @@ TEST_F(JointLimitsHandleTest, AssertionTriggering)
   EXPECT_DEATH(PositionJointSoftLimitsHandle().enforceLimits(period), ".*");
   EXPECT_DEATH(EffortJointSoftLimitsHandle().enforceLimits(period), ".*");
   EXPECT_DEATH(VelocityJointSaturationHandle().enforceLimits(period), ".*");
+  EXPECT_DEATH(VelocityJointSoftLimitsHandle().enforceLimits(period), ".*");
+  EXPECT_DEATH(VelocityJointJerkSaturationHandle().enforceLimits(period), ".*");
+  EXPECT_DEATH(PositionJointJerkSaturationHandle().enforceLimits(period), ".*");
 
   // Negative period should trigger an assertion
   EXPECT_DEATH(PositionJointSoftLimitsHandle(cmd_handle, limits, soft_limits).enforceLimits(ros::Duration(-0.1)), ".*");
 
   limits.has_acceleration_limits = true;
   EXPECT_DEATH(VelocityJointSaturationHandle(cmd_handle, limits).enforceLimits(ros::Duration(-0.1)), ".*");
+  EXPECT_DEATH(VelocityJointSoftLimitsHandle(cmd_handle, limits, soft_limits).enforceLimits(ros::Duration(-0.1)),
+               ".*");
 }
 #endif // NDEBUG
 
@@ -161,6 +180,7 @@ TEST_F(JointLimitsHandleTest, HandleConstruction)
   EXPECT_NO_THROW(PositionJointSoftLimitsHandle(cmd_handle, limits, soft_limits));
   EXPECT_NO_THROW(EffortJointSoftLimitsHandle(cmd_handle, limits, soft_limits));
   EXPECT_NO_THROW(VelocityJointSaturationHandle(cmd_handle, limits));
+  EXPECT_NO_THROW(VelocityJointSoftLimitsHandle(cmd_handle, limits, soft_limits));
 }
 
 class PositionJointSoftLimitsHandleTest : public JointLimitsTest, public ::testing::Test {};
@@ -301,6 +321,95 @@ TEST_F(PositionJointSoftLimitsHandleTest, PathologicalSoftBounds)
   }
 }
 
+TEST_F(PositionJointSoftLimitsHandleTest, PeriodChange)
+{
+  // Test setup
+  PositionJointSoftLimitsHandle limits_handle(cmd_handle, limits, soft_limits);
+  pos = 0.0;
+
+  // Bounds follow the current period, not the first one seen
+  const ros::Duration periods[] = {period, ros::Duration(2.0 * period.toSec()), period};
+  for (unsigned int i = 0; i < sizeof(periods) / sizeof(periods[0]); ++i)
+  {
+    const double max_increment = periods[i].toSec() * limits.max_velocity;
+    cmd_handle.setCommand(2.0 * max_increment);
+    limits_handle.enforceLimits(periods[i]);
+    EXPECT_NEAR(max_increment, cmd_handle.getCommand(), EPS);
+  }
+
+  // Period changes within tolerance are not significant
+  const ros::Duration jittery_period(period.toSec() + 1e-7);
+  cmd_handle.setCommand(2.0 * limits.max_velocity);
+  limits_handle.enforceLimits(jittery_period);
+  EXPECT_NEAR(period.toSec() * limits.max_velocity, cmd_handle.getCommand(), EPS);
+}
+
+TEST_F(PositionJointSoftLimitsHandleTest, EnforceAccelerationBounds)
+{
+  // Test setup
+  const double max_increment = period.toSec() * limits.max_velocity;
+  limits.has_acceleration_limits = true;
+  limits.max_acceleration = max_increment / (4.0 * period.toSec() * period.toSec());
+  PositionJointSoftLimitsHandle limits_handle(cmd_handle, limits, soft_limits);
+  pos = 0.0;
+
+  // At rest, position increments are bounded by the acceleration limit
+  vel = 0.0;
+  cmd_handle.setCommand(2.0 * max_increment);
+  limits_handle.enforceLimits(period);
+  EXPECT_NEAR(max_increment / 4.0, cmd_handle.getCommand(), EPS);
+
+  cmd_handle.setCommand(-2.0 * max_increment);
+  limits_handle.enforceLimits(period);
+  EXPECT_NEAR(-max_increment / 4.0, cmd_handle.getCommand(), EPS);
+
+  // Moving, position increments are centered around the current motion...
+  vel = limits.max_velocity / 2.0;
+  cmd_handle.setCommand(-2.0 * max_increment);
+  limits_handle.enforceLimits(period);
+  EXPECT_NEAR(max_increment / 4.0, cmd_handle.getCommand(), EPS);
+
+  // ...but velocity limits take precedence
+  vel = limits.max_velocity;
+  cmd_handle.setCommand(2.0 * max_increment);
+  limits_handle.enforceLimits(period);
+  EXPECT_NEAR(max_increment, cmd_handle.getCommand(), EPS);
+}
+
+TEST_F(PositionJointSoftLimitsHandleTest, AngleWraparound)
+{
+  // Continuous joint
+  limits.has_position_limits = false;
+  limits.angle_wraparound = true;
+  PositionJointSoftLimitsHandle limits_handle(cmd_handle, limits, soft_limits);
+  EXPECT_TRUE(limits_handle.hasAngleWraparound());
+
+  const double max_increment = period.toSec() * limits.max_velocity;
+
+  // Wrap-aware state accessors
+  pos = 3.0 * M_PI - 0.05;
+  EXPECT_NEAR(M_PI - 0.05, limits_handle.getPosition(), EPS);
+  EXPECT_NEAR(0.1, limits_handle.getPositionError(-M_PI + 0.05), EPS);
+
+  // Command across the wrapping point, within bounds: same angle, closest revolution
+  cmd_handle.setCommand(-M_PI + 0.05);
+  limits_handle.enforceLimits(period);
+  EXPECT_NEAR(pos + 0.1, cmd_handle.getCommand(), EPS);
+
+  // Command across the wrapping point, beyond bounds
+  cmd_handle.setCommand(-M_PI + 0.5);
+  limits_handle.enforceLimits(period);
+  EXPECT_NEAR(pos + max_increment, cmd_handle.getCommand(), EPS);
+
+  // Joints with position limits don't wrap, even if flagged
+  limits.has_position_limits = true;
+  PositionJointSoftLimitsHandle limited_handle(cmd_handle, limits, soft_limits);
+  EXPECT_FALSE(limited_handle.hasAngleWraparound());
+  pos = 0.5;
+  EXPECT_NEAR(0.5, limited_handle.getPosition(), EPS);
+  EXPECT_NEAR(0.5 + 2.0 * M_PI, limited_handle.getPositionError(1.0 + 2.0 * M_PI), EPS);
+}
+
 class VelocityJointSaturationHandleTest : public JointLimitsTest, public ::testing::Test {};
 
 TEST_F(VelocityJointSaturationHandleTest, EnforceVelocityBounds)
@@ -382,6 +491,355 @@ TEST_F(VelocityJointSaturationHandleTest, EnforceAccelerationBounds)
   EXPECT_NEAR(-limits.max_velocity, cmd_handle.getCommand(), EPS); // Max velocity bounded by velocity limit
 }
 
+TEST_F(VelocityJointSaturationHandleTest, PeriodChange)
+{
+  // Test setup
+  limits.has_acceleration_limits = true;
+  limits.max_acceleration = limits.max_velocity / (4.0 * period.toSec());
+  VelocityJointSaturationHandle limits_handle(cmd_handle, limits);
+
+  vel = 0.0;
+
+  // Bounds follow the current period, not the first one seen
+  const ros::Duration periods[] = {period, ros::Duration(2.0 * period.toSec()), period};
+  for (unsigned int i = 0; i < sizeof(periods) / sizeof(periods[0]); ++i)
+  {
+    const double max_increment = periods[i].toSec() * limits.max_acceleration;
+    cmd_handle.setCommand(limits.max_velocity);
+    limits_handle.enforceLimits(periods[i]);
+    EXPECT_NEAR(max_increment, cmd_handle.getCommand(), EPS);
+  }
+}
+
+class VelocityJointSoftLimitsHandleTest : public JointLimitsTest, public ::testing::Test {};
+
+TEST_F(VelocityJointSoftLimitsHandleTest, EnforceVelocityBounds)
+{
+  // Test setup
+  VelocityJointSoftLimitsHandle limits_handle(cmd_handle, limits, soft_limits);
+  pos = 0.0;
+  double cmd;
+
+  // Velocity within bounds
+  cmd = limits.max_velocity / 2.0;
+  cmd_handle.setCommand(cmd);
+  limits_handle.enforceLimits(period);
+  EXPECT_NEAR(cmd, cmd_handle.getCommand(), EPS);
+
+  // Velocity beyond bounds
+  cmd = 2.0 * limits.max_velocity;
+  cmd_handle.setCommand(cmd);
+  limits_handle.enforceLimits(period);
+  EXPECT_NEAR(limits.max_velocity, cmd_handle.getCommand(), EPS);
+
+  cmd = -2.0 * limits.max_velocity;
+  cmd_handle.setCommand(cmd);
+  limits_handle.enforceLimits(period);
+  EXPECT_NEAR(-limits.max_velocity, cmd_handle.getCommand(), EPS);
+}
+
+TEST_F(VelocityJointSoftLimitsHandleTest, EnforcePositionBounds)
+{
+  // Test setup
+  VelocityJointSoftLimitsHandle limits_handle(cmd_handle, limits, soft_limits);
+
+  // On the soft limit, the joint can't move further towards the hard limit
+  pos = soft_limits.max_position;
+  cmd_handle.setCommand(limits.max_velocity);
+  limits_handle.enforceLimits(period);
+  EXPECT_NEAR(0.0, cmd_handle.getCommand(), EPS);
+
+  cmd_handle.setCommand(-limits.max_velocity);
+  limits_handle.enforceLimits(period);
+  EXPECT_NEAR(-limits.max_velocity, cmd_handle.getCommand(), EPS);
+
+  // Beyond the soft limit, the joint is pushed back
+  pos = (soft_limits.max_position + limits.max_position) / 2.0;
+  cmd_handle.setCommand(0.0);
+  limits_handle.enforceLimits(period);
+  EXPECT_NEAR(-soft_limits.k_position * (pos - soft_limits.max_position), cmd_handle.getCommand(), EPS);
+
+  // Continuous joints only have velocity bounds
+  limits.has_position_limits = false;
+  VelocityJointSoftLimitsHandle continuous_handle(cmd_handle, limits, soft_limits);
+  pos = 10.0;
+  cmd_handle.setCommand(2.0 * limits.max_velocity);
+  continuous_handle.enforceLimits(period);
+  EXPECT_NEAR(limits.max_velocity, cmd_handle.getCommand(), EPS);
+}
+
+TEST_F(VelocityJointSoftLimitsHandleTest, EnforceAccelerationBounds)
+{
+  // Test setup
+  limits.has_acceleration_limits = true;
+  limits.max_acceleration = limits.max_velocity / (4.0 * period.toSec());
+  VelocityJointSoftLimitsHandle limits_handle(cmd_handle, limits, soft_limits);
+  pos = 0.0;
+
+  // Velocity changes are bounded by the acceleration limit
+  vel = 0.0;
+  cmd_handle.setCommand(limits.max_velocity);
+  limits_handle.enforceLimits(period);
+  EXPECT_NEAR(limits.max_velocity / 4.0, cmd_handle.getCommand(), EPS);
+
+  // Soft position bounds take precedence
+  pos = soft_limits.max_position;
+  vel = limits.max_velocity / 2.0;
+  cmd_handle.setCommand(limits.max_velocity);
+  limits_handle.enforceLimits(period);
+  EXPECT_NEAR(0.0, cmd_handle.getCommand(), EPS);
+}
+
+class JerkSaturationHandleTest : public JointLimitsTest, public ::testing::Test
+{
+public:
+  JerkSaturationHandleTest()
+  {
+    limits.has_jerk_limits = true;
+    limits.max_jerk = 10.0; // Acceleration changes by at most 1.0 per control period
+  }
+};
+
+TEST_F(JerkSaturationHandleTest, HandleConstruction)
+{
+  JointLimits limits_bad = limits;
+  limits_bad.has_jerk_limits = false;
+  EXPECT_THROW(VelocityJointJerkSaturationHandle(cmd_handle, limits_bad), JointLimitsInterfaceException);
+  EXPECT_THROW(PositionJointJerkSaturationHandle(cmd_handle, limits_bad), JointLimitsInterfaceException);
+
+  limits_bad = limits;
+  limits_bad.has_velocity_limits = false;
+  EXPECT_THROW(VelocityJointJerkSaturationHandle(cmd_handle, limits_bad), JointLimitsInterfaceException);
+  EXPECT_THROW(PositionJointJerkSaturationHandle(cmd_handle, limits_bad), JointLimitsInterfaceException);
+
+  EXPECT_NO_THROW(VelocityJointJerkSaturationHandle(cmd_handle, limits));
+  EXPECT_NO_THROW(PositionJointJerkSaturationHandle(cmd_handle, limits));
+}
+
+TEST_F(JerkSaturationHandleTest, EnforceVelocityJerkBounds)
+{
+  VelocityJointJerkSaturationHandle limits_handle(cmd_handle, limits);
+  vel = 0.0;
+
+  // Velocity step: acceleration ramps up at the maximum jerk
+  const double expected[] = {0.1, 0.3, 0.6, 1.0, 1.5, 2.0, 2.0};
+  for (unsigned int i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i)
+  {
+    cmd_handle.setCommand(10.0);
+    limits_handle.enforceLimits(period);
+    EXPECT_NEAR(expected[i], cmd_handle.getCommand(), EPS) << "cycle " << i;
+  }
+
+  // Reset through a copy: restart from measured velocity with zero acceleration
+  VelocityJointJerkSaturationHandle(limits_handle).reset();
+  vel = -1.0;
+  cmd_handle.setCommand(-10.0);
+  limits_handle.enforceLimits(period);
+  EXPECT_NEAR(-1.1, cmd_handle.getCommand(), EPS);
+}
+
+TEST_F(JerkSaturationHandleTest, EnforceVelocityAccelerationBounds)
+{
+  limits.has_acceleration_limits = true;
+  limits.max_acceleration = 1.5;
+  VelocityJointJerkSaturationHandle limits_handle(cmd_handle, limits);
+  vel = 0.0;
+
+  const double expected[] = {0.1, 0.25, 0.4};
+  for (unsigned int i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i)
+  {
+    cmd_handle.setCommand(10.0);
+    limits_handle.enforceLimits(period);
+    EXPECT_NEAR(expected[i], cmd_handle.getCommand(), EPS) << "cycle " << i;
+  }
+
+  // Command within bounds is left untouched
+  cmd_handle.setCommand(0.45);
+  limits_handle.enforceLimits(period);
+  EXPECT_NEAR(0.45, cmd_handle.getCommand(), EPS);
+}
+
+TEST_F(JerkSaturationHandleTest, EnforcePositionJerkBounds)
+{
+  PositionJointJerkSaturationHandle limits_handle(cmd_handle, limits);
+  pos = 0.0;
+  vel = 0.0;
+
+  // Position step: velocities of 0.1, 0.3, 0.6 are reached in successive cycles
+  const double expected[] = {0.01, 0.04, 0.1};
+  for (unsigned int i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i)
+  {
+    cmd_handle.setCommand(limits.max_position);
+    limits_handle.enforceLimits(period);
+    EXPECT_NEAR(expected[i], cmd_handle.getCommand(), EPS) << "cycle " << i;
+  }
+}
+
+TEST_F(JerkSaturationHandleTest, EnforcePositionBounds)
+{
+  PositionJointJerkSaturationHandle limits_handle(cmd_handle, limits);
+
+  // Moving fast towards the upper hard limit: position limit takes precedence
+  pos = limits.max_position - 0.05;
+  vel = limits.max_velocity;
+  cmd_handle.setCommand(2.0 * limits.max_position);
+  limits_handle.enforceLimits(period);
+  EXPECT_NEAR(limits.max_position, cmd_handle.getCommand(), EPS);
+}
+
+TEST_F(JerkSaturationHandleTest, EnforcePositionAngleWraparound)
+{
+  limits.has_position_limits = false;
+  limits.angle_wraparound = true;
+  PositionJointJerkSaturationHandle limits_handle(cmd_handle, limits);
+  pos = M_PI - 0.005;
+  vel = 0.0;
+
+  // Target is just across the wrapping point: move forward through it instead of going the long way around
+  cmd_handle.setCommand(-M_PI + 0.005);
+  limits_handle.enforceLimits(period);
+  EXPECT_NEAR(pos + 0.01, cmd_handle.getCommand(), EPS);
+}
+
+TEST(JointLimitsViolationsTest, Record)
+{
+  JointLimitsViolations violations;
+  for (unsigned int i = 0; i < LIMIT_TYPE_COUNT; ++i)
+  {
+    EXPECT_EQ(0, violations.getCount(static_cast<LimitType>(i)));
+    EXPECT_EQ(0.0, violations.getMaxMagnitude(static_cast<LimitType>(i)));
+  }
+
+  violations.record(VELOCITY_LIMIT, 0.5);
+  violations.record(VELOCITY_LIMIT, 1.5);
+  violations.record(VELOCITY_LIMIT, 1.0);
+  violations.record(EFFORT_LIMIT,   2.0);
+  EXPECT_EQ(2 + 1, violations.getCount(VELOCITY_LIMIT));
+  EXPECT_DOUBLE_EQ(1.5, violations.getMaxMagnitude(VELOCITY_LIMIT));
+  EXPECT_EQ(1, violations.getCount(EFFORT_LIMIT));
+  EXPECT_DOUBLE_EQ(2.0, violations.getMaxMagnitude(EFFORT_LIMIT));
+  EXPECT_EQ(0, violations.getCount(POSITION_LIMIT));
+
+  violations.reset();
+  EXPECT_EQ(0, violations.getCount(VELOCITY_LIMIT));
+  EXPECT_EQ(0.0, violations.getMaxMagnitude(VELOCITY_LIMIT));
+
+  EXPECT_EQ(string("acceleration"), getLimitTypeName(ACCELERATION_LIMIT));
+}
+
+class JointLimitsViolationsHandleTest : public JointLimitsTest, public ::testing::Test {};
+
+TEST_F(JointLimitsViolationsHandleTest, PositionJointSoftLimits)
+{
+  PositionJointSoftLimitsHandle limits_handle(cmd_handle, limits, soft_limits);
+  boost::shared_ptr<const JointLimitsViolations> violations = limits_handle.getViolations();
+  ASSERT_TRUE(violations);
+  const double max_increment = period.toSec() * limits.max_velocity;
+
+  // Within limits: nothing recorded
+  pos = 0.0;
+  cmd_handle.setCommand(max_increment / 2.0);
+  limits_handle.enforceLimits(period);
+  EXPECT_EQ(0, violations->getCount(VELOCITY_LIMIT));
+  EXPECT_EQ(0, violations->getCount(POSITION_LIMIT));
+
+  // Too fast
+  cmd_handle.setCommand(3.0 * max_increment);
+  limits_handle.enforceLimits(period);
+  EXPECT_EQ(1, violations->getCount(VELOCITY_LIMIT));
+  EXPECT_NEAR(2.0 * max_increment, violations->getMaxMagnitude(VELOCITY_LIMIT), EPS);
+
+  // Towards the hard limit while on the soft limit
+  pos = soft_limits.max_position;
+  cmd_handle.setCommand(limits.max_position);
+  limits_handle.enforceLimits(period);
+  EXPECT_EQ(1, violations->getCount(POSITION_LIMIT));
+
+  // Copies share counters
+  EXPECT_EQ(violations, PositionJointSoftLimitsHandle(limits_handle).getViolations());
+}
+
+TEST_F(JointLimitsViolationsHandleTest, EffortJointSaturation)
+{
+  EffortJointSaturationHandle limits_handle(cmd_handle, limits);
+  boost::shared_ptr<const JointLimitsViolations> violations = limits_handle.getViolations();
+
+  pos = 0.0;
+  vel = 0.0;
+  cmd_handle.setCommand(2.0 * limits.max_effort);
+  limits_handle.enforceLimits(period);
+  EXPECT_EQ(1, violations->getCount(EFFORT_LIMIT));
+  EXPECT_NEAR(limits.max_effort, violations->getMaxMagnitude(EFFORT_LIMIT), EPS);
+
+  vel = 2.0 * limits.max_velocity;
+  cmd_handle.setCommand(1.0);
+  limits_handle.enforceLimits(period);
+  EXPECT_EQ(1, violations->getCount(VELOCITY_LIMIT));
+
+  vel = 0.0;
+  pos = 2.0 * limits.max_position;
+  cmd_handle.setCommand(1.0);
+  limits_handle.enforceLimits(period);
+  EXPECT_EQ(1, violations->getCount(POSITION_LIMIT));
+}
+
+TEST_F(JointLimitsViolationsHandleTest, VelocityJointSaturation)
+{
+  limits.has_acceleration_limits = true;
+  limits.max_acceleration = limits.max_velocity / (4.0 * period.toSec());
+  VelocityJointSaturationHandle limits_handle(cmd_handle, limits);
+  boost::shared_ptr<const JointLimitsViolations> violations = limits_handle.getViolations();
+
+  // Bounded by acceleration
+  vel = 0.0;
+  cmd_handle.setCommand(limits.max_velocity);
+  limits_handle.enforceLimits(period);
+  EXPECT_EQ(1, violations->getCount(ACCELERATION_LIMIT));
+  EXPECT_EQ(0, violations->getCount(VELOCITY_LIMIT));
+
+  // Bounded by velocity
+  vel = limits.max_velocity;
+  cmd_handle.setCommand(2.0 * limits.max_velocity);
+  limits_handle.enforceLimits(period);
+  EXPECT_EQ(1, violations->getCount(VELOCITY_LIMIT));
+}
+
+TEST_F(JointLimitsViolationsHandleTest, VelocityJointSoftLimits)
+{
+  limits.has_acceleration_limits = true;
+  limits.max_acceleration = limits.max_velocity / (4.0 * period.toSec());
+  VelocityJointSoftLimitsHandle limits_handle(cmd_handle, limits, soft_limits);
+  boost::shared_ptr<const JointLimitsViolations> violations = limits_handle.getViolations();
+
+  // Bounded by acceleration
+  pos = 0.0;
+  vel = 0.0;
+  cmd_handle.setCommand(limits.max_velocity);
+  limits_handle.enforceLimits(period);
+  EXPECT_EQ(1, violations->getCount(ACCELERATION_LIMIT));
+
+  // Bounded by soft position limit
+  pos = soft_limits.max_position;
+  cmd_handle.setCommand(limits.max_velocity / 8.0);
+  limits_handle.enforceLimits(period);
+  EXPECT_EQ(1, violations->getCount(POSITION_LIMIT));
+  EXPECT_EQ(0, violations->getCount(VELOCITY_LIMIT));
+}
+
+TEST_F(JointLimitsViolationsHandleTest, VelocityJointJerkSaturation)
+{
+  limits.has_jerk_limits = true;
+  limits.max_jerk = 10.0;
+  VelocityJointJerkSaturationHandle limits_handle(cmd_handle, limits);
+  boost::shared_ptr<const JointLimitsViolations> violations = limits_handle.getViolations();
+
+  vel = 0.0;
+  cmd_handle.setCommand(1.0);
+  limits_handle.enforceLimits(period);
+  EXPECT_EQ(1, violations->getCount(JERK_LIMIT));
+  EXPECT_NEAR(0.9, violations->getMaxMagnitude(JERK_LIMIT), EPS);
+}
+
 class JointLimitsInterfaceTest :public JointLimitsTest, public ::testing::Test
 {
 public:
@@ -432,6 +890,75 @@ TEST_F(JointLimitsInterfaceTest, InterfaceRegistration)
   EXPECT_GT(cmd_handle2.getPosition(), cmd_handle2.getCommand());
 }
 
+TEST_F(JointLimitsInterfaceTest, SetLimits)
+{
+  // Populate interface
+  PositionJointSoftLimitsInterface iface;
+  iface.registerHandle(PositionJointSoftLimitsHandle(cmd_handle, limits, soft_limits));
+  iface.registerHandle(PositionJointSoftLimitsHandle(cmd_handle2, limits, soft_limits));
+
+  pos = pos2 = 0.0;
+  const double max_increment = period.toSec() * limits.max_velocity;
+  cmd_handle.setCommand(2.0 * max_increment);
+  iface.enforceLimits(period);
+  EXPECT_NEAR(max_increment, cmd_handle.getCommand(), EPS);
+
+  // New limits are picked up in the next cycle, only by the affected joint
+  JointLimits new_limits = limits;
+  new_limits.max_velocity = limits.max_velocity / 2.0;
+  iface.setLimits(name, new_limits);
+
+  cmd_handle.setCommand(2.0 * max_increment);
+  cmd_handle2.setCommand(2.0 * max_increment);
+  iface.enforceLimits(period);
+  EXPECT_NEAR(max_increment / 2.0, cmd_handle.getCommand(),  EPS);
+  EXPECT_NEAR(max_increment,       cmd_handle2.getCommand(), EPS);
+
+  // Soft limits are preserved unless explicitly replaced
+  pos = soft_limits.max_position;
+  cmd_handle.setCommand(limits.max_position);
+  iface.enforceLimits(period);
+  EXPECT_NEAR(pos, cmd_handle.getCommand(), EPS);
+
+  SoftJointLimits new_soft_limits = soft_limits;
+  new_soft_limits.max_position = limits.max_position;
+  iface.setLimits(name, new_limits, new_soft_limits);
+  cmd_handle.setCommand(limits.max_position);
+  iface.enforceLimits(period);
+  EXPECT_NEAR(pos + max_increment / 2.0, cmd_handle.getCommand(), EPS);
+
+  // Limits required by the handle can't be dropped, and joints must exist
+  JointLimits bad_limits = limits;
+  bad_limits.has_velocity_limits = false;
+  EXPECT_THROW(iface.setLimits(name, bad_limits), JointLimitsInterfaceException);
+  EXPECT_THROW(iface.setLimits("unknown_name", limits), JointLimitsInterfaceException);
+}
+
+TEST(LimitsBufferTest, ReadWrite)
+{
+  JointLimits limits;
+  limits.max_velocity = 1.0;
+  SoftJointLimits soft_limits;
+  joint_limits_interface::internal::LimitsBuffer buffer(limits, soft_limits);
+
+  // Nothing new to read
+  boost::uint64_t version = 0;
+  JointLimits read_limits;
+  SoftJointLimits read_soft_limits;
+  EXPECT_FALSE(buffer.read(version, read_limits, read_soft_limits));
+
+  // Only the latest of several updates is read
+  for (unsigned int i = 2; i <= 4; ++i)
+  {
+    limits.max_velocity = i;
+    buffer.write(limits, soft_limits);
+  }
+  EXPECT_TRUE(buffer.read(version, read_limits, read_soft_limits));
+  EXPECT_EQ(4.0, read_limits.max_velocity);
+  EXPECT_EQ(3, version);
+  EXPECT_FALSE(buffer.read(version, read_limits, read_soft_limits));
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -154,6 +154,62 @@ TEST(JointLimitsRosParamTest, GetJointLimits)
   }
 }
 
+TEST(JointLimitsRosParamTest, GetAllJointLimits)
+{
+  ros::NodeHandle nh("test");
+
+  // Invalid specification
+  {
+    std::map<string, JointLimits> limits;
+    EXPECT_FALSE(getAllJointLimits(ros::NodeHandle(), limits));
+    EXPECT_TRUE(limits.empty());
+  }
+
+  // Bulk query yields the same result as per-joint queries
+  {
+    std::map<string, JointLimits> limits;
+    EXPECT_TRUE(getAllJointLimits(nh, limits));
+    EXPECT_EQ(6, limits.size());
+
+    const char* names[] = {"foo_joint", "yinfoo_joint", "yangfoo_joint", "antifoo_joint", "bar_joint", "baz_joint"};
+    for (unsigned int i = 0; i < sizeof(names) / sizeof(names[0]); ++i)
+    {
+      ASSERT_EQ(1, limits.count(names[i]));
+      const JointLimits& bulk_limits = limits[names[i]];
+
+      JointLimits joint_limits;
+      EXPECT_TRUE(getJointLimits(names[i], nh, joint_limits));
+      EXPECT_EQ(joint_limits.has_position_limits,     bulk_limits.has_position_limits);
+      EXPECT_EQ(joint_limits.min_position,            bulk_limits.min_position);
+      EXPECT_EQ(joint_limits.max_position,            bulk_limits.max_position);
+      EXPECT_EQ(joint_limits.has_velocity_limits,     bulk_limits.has_velocity_limits);
+      EXPECT_EQ(joint_limits.max_velocity,            bulk_limits.max_velocity);
+      EXPECT_EQ(joint_limits.has_acceleration_limits, bulk_limits.has_acceleration_limits);
+      EXPECT_EQ(joint_limits.max_acceleration,        bulk_limits.max_acceleration);
+      EXPECT_EQ(joint_limits.has_jerk_limits,         bulk_limits.has_jerk_limits);
+      EXPECT_EQ(joint_limits.max_jerk,                bulk_limits.max_jerk);
+      EXPECT_EQ(joint_limits.has_effort_limits,       bulk_limits.has_effort_limits);
+      EXPECT_EQ(joint_limits.max_effort,              bulk_limits.max_effort);
+      EXPECT_EQ(joint_limits.angle_wraparound,        bulk_limits.angle_wraparound);
+    }
+  }
+
+  // Existing entries are overridden field-wise, entries not in the parameter server are left untouched
+  {
+    std::map<string, JointLimits> limits;
+    limits["bar_joint"].has_effort_limits = true;
+    limits["bar_joint"].max_effort = 10.0;
+    limits["unknown_joint"].has_velocity_limits = true;
+
+    EXPECT_TRUE(getAllJointLimits(nh, limits));
+    EXPECT_TRUE(limits["bar_joint"].has_velocity_limits);
+    EXPECT_EQ(2.0, limits["bar_joint"].max_velocity);
+    EXPECT_TRUE(limits["bar_joint"].has_effort_limits);
+    EXPECT_EQ(10.0, limits["bar_joint"].max_effort);
+    EXPECT_TRUE(limits["unknown_joint"].has_velocity_limits);
+  }
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
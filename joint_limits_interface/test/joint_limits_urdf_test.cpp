@@ -184,6 +184,106 @@ TEST_F(JointLimitsUrdfTest, GetSoftJointLimits)
   }
 }
 
+TEST_F(JointLimitsUrdfTest, JointLimitsTable)
+{
+  // Empty model
+  {
+    urdf::ModelInterface model;
+    JointLimitsTable table(model);
+    EXPECT_EQ(0, table.size());
+    EXPECT_TRUE(table.getNames().empty());
+    EXPECT_TRUE(0 == table.findJointLimits("foo"));
+  }
+
+  // Model with joints with and without limits specification
+  {
+    urdf_joint->type = urdf::Joint::REVOLUTE;
+    boost::shared_ptr<urdf::Joint> urdf_joint_fixed(new urdf::Joint);
+    urdf_joint_fixed->type = urdf::Joint::FIXED;
+
+    urdf::ModelInterface model;
+    model.joints_["foo"] = urdf_joint;
+    model.joints_["bar"] = urdf_joint_fixed;
+
+    JointLimitsTable table(model);
+    ASSERT_EQ(2, table.size());
+    ASSERT_EQ(2, table.getJointLimits().size());
+    ASSERT_EQ(2, table.getSoftJointLimits().size());
+
+    // Joints are sorted by name
+    EXPECT_EQ("bar", table.getNames()[0]);
+    EXPECT_EQ("foo", table.getNames()[1]);
+
+    std::size_t index;
+    EXPECT_FALSE(table.getIndex("baz", index));
+    EXPECT_TRUE(table.getIndex("foo", index));
+    EXPECT_EQ(1, index);
+    EXPECT_TRUE(table.getIndex("bar", index));
+    EXPECT_EQ(0, index);
+
+    // Joint without limits
+    EXPECT_FALSE(table.hasJointLimits(0));
+    EXPECT_FALSE(table.hasSoftJointLimits(0));
+    EXPECT_TRUE(0 == table.findJointLimits("bar"));
+    EXPECT_TRUE(0 == table.findSoftJointLimits("bar"));
+
+    // Joint with limits: same values as per-joint queries
+    EXPECT_TRUE(table.hasJointLimits(1));
+    EXPECT_TRUE(table.hasSoftJointLimits(1));
+
+    JointLimits limits;
+    SoftJointLimits soft_limits;
+    getJointLimits(urdf_joint, limits);
+    getSoftJointLimits(urdf_joint, soft_limits);
+
+    const JointLimits* table_limits = table.findJointLimits("foo");
+    ASSERT_TRUE(0 != table_limits);
+    EXPECT_EQ(&table.getJointLimits()[1], table_limits);
+    EXPECT_TRUE(table_limits->has_position_limits);
+    EXPECT_DOUBLE_EQ(limits.min_position, table_limits->min_position);
+    EXPECT_DOUBLE_EQ(limits.max_position, table_limits->max_position);
+    EXPECT_DOUBLE_EQ(limits.max_velocity, table_limits->max_velocity);
+    EXPECT_DOUBLE_EQ(limits.max_effort,   table_limits->max_effort);
+
+    const SoftJointLimits* table_soft_limits = table.findSoftJointLimits("foo");
+    ASSERT_TRUE(0 != table_soft_limits);
+    EXPECT_DOUBLE_EQ(soft_limits.min_position, table_soft_limits->min_position);
+    EXPECT_DOUBLE_EQ(soft_limits.max_position, table_soft_limits->max_position);
+    EXPECT_DOUBLE_EQ(soft_limits.k_position,   table_soft_limits->k_position);
+    EXPECT_DOUBLE_EQ(soft_limits.k_velocity,   table_soft_limits->k_velocity);
+  }
+}
+
+TEST(JointLimitsUrdfSharedTest, GetSharedJointLimitsTable)
+{
+  const string urdf_str =
+    "<robot name=\"robot\">"
+    "  <link name=\"link1\"/>"
+    "  <link name=\"link2\"/>"
+    "  <joint name=\"foo\" type=\"revolute\">"
+    "    <parent link=\"link1\"/>"
+    "    <child link=\"link2\"/>"
+    "    <limit lower=\"-1.0\" upper=\"1.0\" effort=\"8.0\" velocity=\"2.0\"/>"
+    "  </joint>"
+    "</robot>";
+
+  // Invalid description
+  EXPECT_FALSE(getSharedJointLimitsTable("<robot"));
+
+  // Users of the same description share the same table
+  boost::shared_ptr<const JointLimitsTable> table1 = getSharedJointLimitsTable(urdf_str);
+  boost::shared_ptr<const JointLimitsTable> table2 = getSharedJointLimitsTable(urdf_str);
+  ASSERT_TRUE(table1);
+  EXPECT_EQ(table1, table2);
+
+  const JointLimits* limits = table1->findJointLimits("foo");
+  ASSERT_TRUE(0 != limits);
+  EXPECT_DOUBLE_EQ(-1.0, limits->min_position);
+  EXPECT_DOUBLE_EQ( 1.0, limits->max_position);
+  EXPECT_DOUBLE_EQ( 2.0, limits->max_velocity);
+  EXPECT_DOUBLE_EQ( 8.0, limits->max_effort);
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
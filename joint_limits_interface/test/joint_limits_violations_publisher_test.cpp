@@ -0,0 +1,151 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013, PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of hiDOF, Inc. nor the names of its
+//     contributors may be used to endorse or promote products derived from
+//     this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//////////////////////////////////////////////////////////////////////////////
+
+/// \author Adolfo Rodriguez Tsouroukdissian
+
+#include <string>
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+#include <diagnostic_msgs/DiagnosticArray.h>
+#include <joint_limits_interface/joint_limits_violations_publisher.h>
+
+using std::string;
+using namespace hardware_interface;
+using namespace joint_limits_interface;
+
+class ViolationsListener
+{
+public:
+  void callback(const diagnostic_msgs::DiagnosticArrayConstPtr& msg) {msg_ = msg;}
+
+  /// Wait for the next message, for up to a few seconds
+  diagnostic_msgs::DiagnosticArrayConstPtr waitForMessage()
+  {
+    msg_.reset();
+    for (unsigned int i = 0; i < 500 && !msg_; ++i)
+    {
+      ros::spinOnce();
+      ros::WallDuration(0.01).sleep();
+    }
+    return msg_;
+  }
+
+private:
+  diagnostic_msgs::DiagnosticArrayConstPtr msg_;
+};
+
+string getValue(const diagnostic_msgs::DiagnosticStatus& status, const string& key)
+{
+  for (unsigned int i = 0; i < status.values.size(); ++i)
+  {
+    if (status.values[i].key == key) {return status.values[i].value;}
+  }
+  return "";
+}
+
+TEST(JointLimitsViolationsPublisherTest, PublishViolations)
+{
+  ros::NodeHandle nh("violations_test");
+
+  double pos = 0.0, vel = 0.0, eff = 0.0, cmd = 0.0;
+  JointHandle cmd_handle(JointStateHandle("foo_joint", &pos, &vel, &eff), &cmd);
+  JointLimits limits;
+  limits.has_velocity_limits = true;
+  limits.max_velocity = 2.0;
+  VelocityJointSaturationHandle limits_handle(cmd_handle, limits);
+  const ros::Duration period(0.1);
+
+  // Publish on every update
+  JointLimitsViolationsPublisher publisher(nh, 1);
+  publisher.addHandle(limits_handle);
+
+  ViolationsListener listener;
+  ros::Subscriber sub = nh.subscribe("joint_limits_violations", 1, &ViolationsListener::callback, &listener);
+  for (unsigned int i = 0; i < 500 && sub.getNumPublishers() == 0; ++i) {ros::WallDuration(0.01).sleep();}
+  ASSERT_EQ(1u, sub.getNumPublishers());
+
+  // Clamped command: counted, and reported as a warning
+  cmd = 3.0;
+  limits_handle.enforceLimits(period);
+  EXPECT_EQ(limits.max_velocity, cmd);
+  publisher.update();
+  diagnostic_msgs::DiagnosticArrayConstPtr msg = listener.waitForMessage();
+  ASSERT_TRUE(msg);
+  ASSERT_EQ(1u, msg->status.size());
+  EXPECT_EQ("foo_joint", msg->status[0].name);
+  EXPECT_EQ(diagnostic_msgs::DiagnosticStatus::WARN, msg->status[0].level);
+  EXPECT_EQ("1", getValue(msg->status[0], "velocity violations"));
+  EXPECT_EQ("1", getValue(msg->status[0], "velocity max correction"));
+  EXPECT_EQ("0", getValue(msg->status[0], "position violations"));
+
+  // No new violations: the count is kept, but the joint is fine again
+  cmd = 1.0;
+  limits_handle.enforceLimits(period);
+  publisher.update();
+  msg = listener.waitForMessage();
+  ASSERT_TRUE(msg);
+  ASSERT_EQ(1u, msg->status.size());
+  EXPECT_EQ(diagnostic_msgs::DiagnosticStatus::OK, msg->status[0].level);
+  EXPECT_EQ("1", getValue(msg->status[0], "velocity violations"));
+}
+
+TEST(JointLimitsViolationsPublisherTest, Decimation)
+{
+  ros::NodeHandle nh("decimation_test");
+
+  double pos = 0.0, vel = 0.0, eff = 0.0, cmd = 0.0;
+  JointHandle cmd_handle(JointStateHandle("bar_joint", &pos, &vel, &eff), &cmd);
+  JointLimits limits;
+  limits.has_velocity_limits = true;
+  limits.max_velocity = 2.0;
+  VelocityJointSaturationHandle limits_handle(cmd_handle, limits);
+
+  // Publish once every three updates
+  JointLimitsViolationsPublisher publisher(nh, 3);
+  publisher.addHandle(limits_handle);
+
+  ViolationsListener listener;
+  ros::Subscriber sub = nh.subscribe("joint_limits_violations", 1, &ViolationsListener::callback, &listener);
+  for (unsigned int i = 0; i < 500 && sub.getNumPublishers() == 0; ++i) {ros::WallDuration(0.01).sleep();}
+  ASSERT_EQ(1u, sub.getNumPublishers());
+
+  publisher.update();
+  publisher.update();
+  EXPECT_FALSE(listener.waitForMessage());
+  publisher.update();
+  diagnostic_msgs::DiagnosticArrayConstPtr msg = listener.waitForMessage();
+  ASSERT_TRUE(msg);
+  ASSERT_EQ(1u, msg->status.size());
+  EXPECT_EQ("bar_joint", msg->status[0].name);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "JointLimitsViolationsPublisherTestNode");
+  return RUN_ALL_TESTS();
+}
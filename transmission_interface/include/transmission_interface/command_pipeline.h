@@ -0,0 +1,165 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013, PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of hiDOF, Inc. nor the names of its
+//     contributors may be used to endorse or promote products derived from
+//     this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef TRANSMISSION_INTERFACE_COMMAND_PIPELINE_H
+#define TRANSMISSION_INTERFACE_COMMAND_PIPELINE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <ros/duration.h>
+
+#include <joint_limits_interface/joint_limits_interface.h>
+#include <joint_limits_interface/joint_limits_interface_exception.h>
+
+#include <transmission_interface/transmission_info.h>
+#include <transmission_interface/transmission_interface.h>
+#include <transmission_interface/transmission_interface_exception.h>
+
+namespace transmission_interface
+{
+
+/**
+ * \brief Enforce joint limits and propagate joint commands to actuators in a single pass.
+ *
+ * The usual command path of a robot hardware abstraction is to enforce the limits of all joints, and then propagate
+ * all joint commands to actuator commands. This class fuses both steps: joints are grouped by the transmission they
+ * belong to, and each group has its limits enforced immediately before its transmission is propagated, while the joint
+ * commands are still in cache.
+ *
+ * The pipeline is configured once from the handles registered in a joint limits interface and a transmission
+ * interface. Handles are copied into contiguous storage, so the real-time update does not walk any map.
+ *
+ * \tparam LimitsHandle Joint limits handle type, eg. joint_limits_interface::PositionJointSoftLimitsHandle.
+ * \tparam TransmissionHandle Joint to actuator transmission handle type, eg. JointToActuatorPositionHandle.
+ */
+template <class LimitsHandle, class TransmissionHandle>
+class CommandPipeline
+{
+public:
+  typedef joint_limits_interface::JointLimitsInterface<LimitsHandle> LimitsInterfaceType;
+  typedef TransmissionInterface<TransmissionHandle>                  TransmissionInterfaceType;
+
+  /** \name Non Real-Time Safe Functions
+   *\{*/
+  /**
+   * \brief Add a transmission and the limits of the joints it drives to the pipeline.
+   *
+   * Joints that are not registered in \e limits_iface (eg. joints without limits) are propagated, but not limited.
+   * \param limits_iface Interface holding the limits handles of the transmission joints.
+   * \param transmission_iface Interface holding the transmission handle.
+   * \param transmission_name Name of the transmission, as registered in \e transmission_iface.
+   * \param joint_names Names of the joints driven by the transmission.
+   * \throw TransmissionInterfaceException If \e transmission_name is not registered in \e transmission_iface.
+   */
+  void addGroup(LimitsInterfaceType&            limits_iface,
+                TransmissionInterfaceType&      transmission_iface,
+                const std::string&              transmission_name,
+                const std::vector<std::string>& joint_names)
+  {
+    const TransmissionHandle transmission_handle = transmission_iface.getHandle(transmission_name);
+
+    const std::vector<std::string> limited_joints = limits_iface.getNames();
+    for (std::vector<std::string>::const_iterator it = joint_names.begin(); it != joint_names.end(); ++it)
+    {
+      if (std::find(limited_joints.begin(), limited_joints.end(), *it) != limited_joints.end())
+      {
+        limits_handles_.push_back(limits_iface.getHandle(*it));
+      }
+    }
+    transmission_handles_.push_back(transmission_handle);
+    group_ends_.push_back(limits_handles_.size());
+  }
+
+  /**
+   * \brief Add all transmissions described in \e infos that are registered in \e transmission_iface.
+   * \param limits_iface Interface holding the limits handles of the transmission joints.
+   * \param transmission_iface Interface holding the transmission handles.
+   * \param infos Transmission descriptions, as obtained from the TransmissionParser.
+   */
+  void configure(LimitsInterfaceType&                 limits_iface,
+                 TransmissionInterfaceType&           transmission_iface,
+                 const std::vector<TransmissionInfo>& infos)
+  {
+    const std::vector<std::string> transmissions = transmission_iface.getNames();
+    for (std::vector<TransmissionInfo>::const_iterator it = infos.begin(); it != infos.end(); ++it)
+    {
+      if (std::find(transmissions.begin(), transmissions.end(), it->name_) == transmissions.end()) {continue;}
+
+      std::vector<std::string> joint_names;
+      for (std::vector<JointInfo>::const_iterator jit = it->joints_.begin(); jit != it->joints_.end(); ++jit)
+      {
+        joint_names.push_back(jit->name_);
+      }
+      addGroup(limits_iface, transmission_iface, it->name_, joint_names);
+    }
+  }
+
+  /** \brief Remove all transmissions and joints from the pipeline. */
+  void clear()
+  {
+    limits_handles_.clear();
+    transmission_handles_.clear();
+    group_ends_.clear();
+  }
+
+  /** \return Number of transmissions in the pipeline. */
+  std::size_t size() const {return transmission_handles_.size();}
+  /*\}*/
+
+  /** \name Real-Time Safe Functions
+   *\{*/
+  /**
+   * \brief Enforce joint limits and propagate joint commands to actuators, one transmission at a time.
+   * \param period Control period.
+   */
+  void update(const ros::Duration& period)
+  {
+    std::size_t joint = 0;
+    for (std::size_t group = 0; group < transmission_handles_.size(); ++group)
+    {
+      for (; joint < group_ends_[group]; ++joint)
+      {
+        limits_handles_[joint].enforceLimits(period);
+      }
+      transmission_handles_[group].propagate();
+    }
+  }
+  /*\}*/
+
+private:
+  std::vector<LimitsHandle>       limits_handles_;
+  std::vector<TransmissionHandle> transmission_handles_;
+  std::vector<std::size_t>        group_ends_; ///< One past the last limits handle of each transmission.
+};
+
+} // transmission_interface
+
+#endif // TRANSMISSION_INTERFACE_COMMAND_PIPELINE_H
@@ -0,0 +1,126 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Open Source Robotics Foundation
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Open Source Robotics Foundation
+ *     nor the names of its contributors may be
+ *     used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/**
+ * \file
+ * \brief Binary cache of the data derived from a robot description (transmissions and joint limits).
+ */
+
+#ifndef TRANSMISSION_INTERFACE_ROBOT_DESCRIPTION_CACHE_H
+#define TRANSMISSION_INTERFACE_ROBOT_DESCRIPTION_CACHE_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+// ros_control
+#include <joint_limits_interface/joint_limits.h>
+#include <transmission_interface/transmission_info.h>
+
+namespace transmission_interface
+{
+
+/**
+ * \brief Data derived from a robot description and its joint limits configuration.
+ */
+struct RobotDescriptionData
+{
+  std::vector<TransmissionInfo> transmissions_;
+  std::map<std::string, joint_limits_interface::JointLimits> joint_limits_;          ///< Indexed by joint name.
+  std::map<std::string, joint_limits_interface::SoftJointLimits> soft_joint_limits_; ///< Indexed by joint name.
+};
+
+/**
+ * \brief Persists \ref RobotDescriptionData to disk, so that restarts with an unchanged robot description can skip
+ * parsing the URDF and querying joint limits from the parameter server.
+ *
+ * Cache files are tagged with a key computed from the robot description and the limits configuration they were
+ * derived from. Loading a cache file memory-maps it and decodes its contents, and fails if the stored key does not
+ * match the requested one, ie. if the cache is stale. Cached data is stored in host byte order: cache files written on
+ * a host of the other byte order are rejected on load.
+ *
+ * The cache depends on \c joint_limits_interface, which is a catkin-only package, so it is not built with rosbuild.
+ *
+ * The cache is not used implicitly by any ros_control package: robot hardware abstractions that load transmissions
+ * and joint limits at startup opt into it as follows.
+ *
+ * \code
+ * const boost::uint64_t key = RobotDescriptionCache::computeKey(urdf_string, limits_param.toXml());
+ * RobotDescriptionData data;
+ * if (!RobotDescriptionCache::load(cache_path, key, data))
+ * {
+ *   // Populate data with TransmissionParser::parse, getJointLimits, etc...
+ *   RobotDescriptionCache::save(cache_path, key, data);
+ * }
+ * \endcode
+ */
+class RobotDescriptionCache
+{
+public:
+  /**
+   * \brief Compute the key identifying a robot description and its limits configuration
+   * \param[in] robot_description - XML string of the robot description (URDF)
+   * \param[in] limits_description - Serialized limits configuration, eg. the XML-RPC representation of the
+   * \c joint_limits parameter namespace. Can be left empty if limits are not loaded from the parameter server
+   * \return cache key. It is stable across processes and hosts, regardless of their byte order
+   */
+  static boost::uint64_t computeKey(const std::string& robot_description, const std::string& limits_description);
+
+  /**
+   * \brief Load cached robot description data
+   * \param[in] path - Cache file path
+   * \param[in] key - Expected cache key, as returned by \ref computeKey
+   * \param[out] data - Cached data. Existing contents are replaced on success, and left untouched otherwise
+   * \return true if the cache file exists, is valid and matches \e key
+   */
+  static bool load(const std::string& path, boost::uint64_t key, RobotDescriptionData& data);
+
+  /**
+   * \brief Save robot description data to a cache file
+   *
+   * The file is written under a temporary name and then renamed, so concurrent readers never see partial contents.
+   * \param[in] path - Cache file path
+   * \param[in] key - Cache key, as returned by \ref computeKey
+   * \param[in] data - Data to cache
+   * \return true if the cache file was successfully written
+   */
+  static bool save(const std::string& path, boost::uint64_t key, const RobotDescriptionData& data);
+};
+
+} // namespace
+
+#endif
@@ -41,15 +41,82 @@
 #ifndef TRANSMISSION_INTERFACE_TRANSMISSION_INTERFACE_INFO_H
 #define TRANSMISSION_INTERFACE_TRANSMISSION_INTERFACE_INFO_H
 
+#include <cstddef>
+#include <map>
 #include <vector>
 #include <string>
 
-// XML
-#include <tinyxml.h>
-
 namespace transmission_interface
 {
 
+/**
+ * \brief Self-contained copy of an XML element, its attributes, text and descendant elements.
+ *
+ * Elements are stored by value in a contiguous array in document order, the first one being the subtree root. Each
+ * element refers to its parent by index, hence a subtree remains valid after the XML document it was copied from has
+ * been destroyed, and can be freely copied along with the structs that contain it.
+ */
+struct XmlSubtree
+{
+  /** \brief Single element of the subtree. */
+  struct Element
+  {
+    std::string name_;
+    std::string text_;
+    std::map<std::string, std::string> attributes_;
+    std::size_t parent_; ///< Index of the parent element, or \ref npos for the subtree root.
+  };
+
+  static const std::size_t npos = static_cast<std::size_t>(-1);
+
+  std::vector<Element> elements_;
+
+  /**
+   * \param parent Index of the parent element. Defaults to the subtree root.
+   * \return Index of the first child of \e parent called \e name, or \ref npos if there is none.
+   */
+  std::size_t findChild(const std::string& name, std::size_t parent = 0) const
+  {
+    for (std::size_t i = parent + 1; i < elements_.size(); ++i)
+    {
+      if (elements_[i].parent_ == parent && elements_[i].name_ == name) {return i;}
+    }
+    return npos;
+  }
+
+  /**
+   * \brief Get the text of a child element, eg. <tt>\<mechanicalReduction\>50\</mechanicalReduction\></tt>.
+   * \param[in] name Child element name.
+   * \param[out] text Child element text. Left untouched if the child element does not exist.
+   * \param[in] parent Index of the parent element. Defaults to the subtree root.
+   * \return true if the child element exists.
+   */
+  bool getChildText(const std::string& name, std::string& text, std::size_t parent = 0) const
+  {
+    const std::size_t child = findChild(name, parent);
+    if (child == npos) {return false;}
+    text = elements_[child].text_;
+    return true;
+  }
+
+  /**
+   * \brief Get the value of an element attribute.
+   * \param[in] name Attribute name.
+   * \param[out] value Attribute value. Left untouched if the attribute does not exist.
+   * \param[in] element Index of the element. Defaults to the subtree root.
+   * \return true if the attribute exists.
+   */
+  bool getAttribute(const std::string& name, std::string& value, std::size_t element = 0) const
+  {
+    if (element >= elements_.size()) {return false;}
+    const std::map<std::string, std::string>& attributes = elements_[element].attributes_;
+    const std::map<std::string, std::string>::const_iterator it = attributes.find(name);
+    if (it == attributes.end()) {return false;}
+    value = it->second;
+    return true;
+  }
+};
+
 /**
  * \brief Contains semantic info about a given joint loaded from XML (URDF)
  */
@@ -58,7 +125,7 @@ struct JointInfo
   std::string name_;
   std::string hardware_interface_;
   std::string role_;
-  TiXmlElement* xml_element_;
+  XmlSubtree xml_element_; ///< Copy of the <tt>\<joint\></tt> element, for reading additional properties.
 };
 
 /**
@@ -67,7 +134,7 @@ struct JointInfo
 struct ActuatorInfo {
   std::string name_;
   std::string hardware_interface_;
-  TiXmlElement* xml_element_;
+  XmlSubtree xml_element_; ///< Copy of the <tt>\<actuator\></tt> element, for reading additional properties.
 };
 
 /**
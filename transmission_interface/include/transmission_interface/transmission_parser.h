@@ -73,6 +73,11 @@ public:
 
   /**
    * \brief Parses the tranmission elements of a URDF
+   *
+   * The URDF string is not loaded into a DOM as a whole. Instead, it is scanned for the <tt>\<tranmission\></tt>
+   * children of the root element, and only these are handed to the XML parser. All other elements (links, joints,
+   * meshes, etc.) are skipped over without being materialized, which keeps parse time and memory usage low for
+   * large robot descriptions.
    * \param[in] urdf_string - XML string of a valid URDF file that contains <tt>\<tranmission\></tt> elements
    * \param[out] transmissions - vector of loaded transmission meta data
    * \return true if parsing was successful
@@ -80,6 +85,15 @@ public:
   static bool parse(const std::string& urdf_string, std::vector<TransmissionInfo>& transmissions);
 
 private:
+  /**
+   * \brief Extracts the XML text of the tranmission elements of a URDF
+   * \param[in] urdf_string - XML string of a URDF file
+   * \param[out] transmissions_xml - XML text of each <tt>\<tranmission\></tt> child of the root element, in
+   * document order
+   * \return true if the URDF string is well-formed enough to be scanned (balanced tags, terminated markup)
+   */
+  static bool extractTransmissions(const std::string& urdf_string, std::vector<std::string>& transmissions_xml);
+
   /**
    * \brief Parses the joint elements within tranmission elements of a URDF
    * \param[in] trans_it - pointer to the current XML element being parsed
@@ -96,6 +110,13 @@ private:
    */
   static bool parseActuators(TiXmlElement *trans_it, std::vector<ActuatorInfo>& actuators);
 
+  /**
+   * \brief Copies an XML element and all its descendants into a self-contained subtree
+   * \param[in] element - pointer to the XML element to copy
+   * \param[out] subtree - resulting subtree. Existing contents are replaced
+   */
+  static void copyElement(const TiXmlElement *element, XmlSubtree& subtree);
+
 }; // class
 
 } // namespace
@@ -0,0 +1,450 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Open Source Robotics Foundation
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Open Source Robotics Foundation
+ *     nor the names of its contributors may be
+ *     used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <ros/console.h>
+
+#include <transmission_interface/robot_description_cache.h>
+
+namespace transmission_interface
+{
+
+namespace
+{
+
+// Written in host byte order like all cached data, so files written on a host of the other byte order fail to match it
+const boost::uint32_t CACHE_MAGIC   = 0x31434452; // "RDC1"
+const boost::uint32_t CACHE_VERSION = 1;          // Increase whenever the encoding of the cached data changes
+
+/// 64-bit FNV-1a hash, chained through \e hash.
+boost::uint64_t fnv1a(const char* data, std::size_t size, boost::uint64_t hash = 14695981039346656037ULL)
+{
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+/// Appends binary-encoded values to a buffer, in host byte order.
+class Encoder
+{
+public:
+  template <class T>
+  void write(const T& val) {buffer_.append(reinterpret_cast<const char*>(&val), sizeof(T));}
+
+  void write(bool val) {write(static_cast<boost::uint8_t>(val ? 1 : 0));}
+
+  void write(const std::string& val)
+  {
+    write(static_cast<boost::uint32_t>(val.size()));
+    buffer_.append(val);
+  }
+
+  void write(const XmlSubtree& val)
+  {
+    write(static_cast<boost::uint32_t>(val.elements_.size()));
+    for (std::vector<XmlSubtree::Element>::const_iterator it = val.elements_.begin(); it != val.elements_.end(); ++it)
+    {
+      write(it->name_);
+      write(it->text_);
+      write(static_cast<boost::uint64_t>(it->parent_));
+      write(static_cast<boost::uint32_t>(it->attributes_.size()));
+      for (std::map<std::string, std::string>::const_iterator attr_it = it->attributes_.begin();
+           attr_it != it->attributes_.end(); ++attr_it)
+      {
+        write(attr_it->first);
+        write(attr_it->second);
+      }
+    }
+  }
+
+  const std::string& buffer() const {return buffer_;}
+
+private:
+  std::string buffer_;
+};
+
+/// Reads binary-encoded values from a memory range. Reading past the end of the range flags the decoder as failed.
+class Decoder
+{
+public:
+  Decoder(const char* begin, const char* end) : pos_(begin), end_(end), ok_(true) {}
+
+  template <class T>
+  void read(T& val)
+  {
+    if (!reserve(sizeof(T))) {return;}
+    std::memcpy(&val, pos_, sizeof(T));
+    pos_ += sizeof(T);
+  }
+
+  void read(bool& val)
+  {
+    boost::uint8_t tmp = 0;
+    read(tmp);
+    val = (tmp != 0);
+  }
+
+  void read(std::string& val)
+  {
+    boost::uint32_t size = 0;
+    read(size);
+    if (!reserve(size)) {return;}
+    val.assign(pos_, size);
+    pos_ += size;
+  }
+
+  void read(XmlSubtree& val)
+  {
+    boost::uint32_t size = 0;
+    read(size);
+    val.elements_.clear();
+    for (boost::uint32_t i = 0; ok_ && i < size; ++i)
+    {
+      XmlSubtree::Element element;
+      boost::uint64_t parent = 0;
+      boost::uint32_t attr_size = 0;
+      read(element.name_);
+      read(element.text_);
+      read(parent);
+      read(attr_size);
+      element.parent_ = static_cast<std::size_t>(parent);
+      for (boost::uint32_t j = 0; ok_ && j < attr_size; ++j)
+      {
+        std::string name, value;
+        read(name);
+        read(value);
+        element.attributes_[name] = value;
+      }
+      val.elements_.push_back(element);
+    }
+  }
+
+  /// \return Number of elements to read, bounded by the remaining data so that corrupt counts fail early.
+  boost::uint32_t readCount()
+  {
+    boost::uint32_t count = 0;
+    read(count);
+    if (count > static_cast<std::size_t>(end_ - pos_)) {ok_ = false;}
+    return ok_ ? count : 0;
+  }
+
+  bool ok() const {return ok_;}
+  bool atEnd() const {return pos_ == end_;}
+
+private:
+  const char* pos_;
+  const char* end_;
+  bool ok_;
+
+  bool reserve(std::size_t size)
+  {
+    if (!ok_ || size > static_cast<std::size_t>(end_ - pos_)) {ok_ = false;}
+    return ok_;
+  }
+};
+
+void encode(const RobotDescriptionData& data, Encoder& enc)
+{
+  using joint_limits_interface::JointLimits;
+  using joint_limits_interface::SoftJointLimits;
+
+  enc.write(static_cast<boost::uint32_t>(data.transmissions_.size()));
+  for (std::vector<TransmissionInfo>::const_iterator it = data.transmissions_.begin(); it != data.transmissions_.end();
+       ++it)
+  {
+    enc.write(it->name_);
+    enc.write(it->type_);
+
+    enc.write(static_cast<boost::uint32_t>(it->joints_.size()));
+    for (std::vector<JointInfo>::const_iterator joint_it = it->joints_.begin(); joint_it != it->joints_.end();
+         ++joint_it)
+    {
+      enc.write(joint_it->name_);
+      enc.write(joint_it->hardware_interface_);
+      enc.write(joint_it->role_);
+      enc.write(joint_it->xml_element_);
+    }
+
+    enc.write(static_cast<boost::uint32_t>(it->actuators_.size()));
+    for (std::vector<ActuatorInfo>::const_iterator act_it = it->actuators_.begin(); act_it != it->actuators_.end();
+         ++act_it)
+    {
+      enc.write(act_it->name_);
+      enc.write(act_it->hardware_interface_);
+      enc.write(act_it->xml_element_);
+    }
+  }
+
+  enc.write(static_cast<boost::uint32_t>(data.joint_limits_.size()));
+  for (std::map<std::string, JointLimits>::const_iterator it = data.joint_limits_.begin();
+       it != data.joint_limits_.end(); ++it)
+  {
+    const JointLimits& limits = it->second;
+    enc.write(it->first);
+    enc.write(limits.min_position);
+    enc.write(limits.max_position);
+    enc.write(limits.max_velocity);
+    enc.write(limits.max_acceleration);
+    enc.write(limits.max_jerk);
+    enc.write(limits.max_effort);
+    enc.write(limits.has_position_limits);
+    enc.write(limits.has_velocity_limits);
+    enc.write(limits.has_acceleration_limits);
+    enc.write(limits.has_jerk_limits);
+    enc.write(limits.has_effort_limits);
+    enc.write(limits.angle_wraparound);
+  }
+
+  enc.write(static_cast<boost::uint32_t>(data.soft_joint_limits_.size()));
+  for (std::map<std::string, SoftJointLimits>::const_iterator it = data.soft_joint_limits_.begin();
+       it != data.soft_joint_limits_.end(); ++it)
+  {
+    const SoftJointLimits& soft_limits = it->second;
+    enc.write(it->first);
+    enc.write(soft_limits.min_position);
+    enc.write(soft_limits.max_position);
+    enc.write(soft_limits.k_position);
+    enc.write(soft_limits.k_velocity);
+  }
+}
+
+bool decode(Decoder& dec, RobotDescriptionData& data)
+{
+  using joint_limits_interface::JointLimits;
+  using joint_limits_interface::SoftJointLimits;
+
+  const boost::uint32_t trans_size = dec.readCount();
+  data.transmissions_.resize(trans_size);
+  for (boost::uint32_t i = 0; dec.ok() && i < trans_size; ++i)
+  {
+    TransmissionInfo& info = data.transmissions_[i];
+    dec.read(info.name_);
+    dec.read(info.type_);
+
+    info.joints_.resize(dec.readCount());
+    for (std::vector<JointInfo>::iterator joint_it = info.joints_.begin(); joint_it != info.joints_.end(); ++joint_it)
+    {
+      dec.read(joint_it->name_);
+      dec.read(joint_it->hardware_interface_);
+      dec.read(joint_it->role_);
+      dec.read(joint_it->xml_element_);
+    }
+
+    info.actuators_.resize(dec.readCount());
+    for (std::vector<ActuatorInfo>::iterator act_it = info.actuators_.begin(); act_it != info.actuators_.end();
+         ++act_it)
+    {
+      dec.read(act_it->name_);
+      dec.read(act_it->hardware_interface_);
+      dec.read(act_it->xml_element_);
+    }
+  }
+
+  const boost::uint32_t limits_size = dec.readCount();
+  for (boost::uint32_t i = 0; dec.ok() && i < limits_size; ++i)
+  {
+    std::string name;
+    JointLimits limits;
+    dec.read(name);
+    dec.read(limits.min_position);
+    dec.read(limits.max_position);
+    dec.read(limits.max_velocity);
+    dec.read(limits.max_acceleration);
+    dec.read(limits.max_jerk);
+    dec.read(limits.max_effort);
+    dec.read(limits.has_position_limits);
+    dec.read(limits.has_velocity_limits);
+    dec.read(limits.has_acceleration_limits);
+    dec.read(limits.has_jerk_limits);
+    dec.read(limits.has_effort_limits);
+    dec.read(limits.angle_wraparound);
+    data.joint_limits_[name] = limits;
+  }
+
+  const boost::uint32_t soft_limits_size = dec.readCount();
+  for (boost::uint32_t i = 0; dec.ok() && i < soft_limits_size; ++i)
+  {
+    std::string name;
+    SoftJointLimits soft_limits;
+    dec.read(name);
+    dec.read(soft_limits.min_position);
+    dec.read(soft_limits.max_position);
+    dec.read(soft_limits.k_position);
+    dec.read(soft_limits.k_velocity);
+    data.soft_joint_limits_[name] = soft_limits;
+  }
+
+  return dec.ok() && dec.atEnd();
+}
+
+} // namespace
+
+boost::uint64_t RobotDescriptionCache::computeKey(const std::string& robot_description,
+                                                  const std::string& limits_description)
+{
+  // Sizes are hashed too, so that moving bytes from one string to the other changes the key. They are hashed in
+  // little-endian order, so that the key does not depend on the byte order of the host
+  const boost::uint64_t sizes[2] = {robot_description.size(), limits_description.size()};
+  char size_bytes[sizeof(sizes)];
+  for (std::size_t i = 0; i < sizeof(sizes); ++i)
+  {
+    size_bytes[i] = static_cast<char>((sizes[i / 8] >> (8 * (i % 8))) & 0xff);
+  }
+  boost::uint64_t key = fnv1a(size_bytes, sizeof(size_bytes));
+  key = fnv1a(robot_description.data(), robot_description.size(), key);
+  key = fnv1a(limits_description.data(), limits_description.size(), key);
+  return key;
+}
+
+bool RobotDescriptionCache::load(const std::string& path, boost::uint64_t key, RobotDescriptionData& data)
+{
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    ROS_DEBUG_STREAM_NAMED("cache","No robot description cache found at '" << path << "'.");
+    return false;
+  }
+
+  struct stat file_stat;
+  const std::size_t header_size = 2 * sizeof(boost::uint32_t) + 2 * sizeof(boost::uint64_t);
+  if (fstat(fd, &file_stat) != 0 || static_cast<std::size_t>(file_stat.st_size) < header_size)
+  {
+    ROS_WARN_STREAM_NAMED("cache","Ignoring invalid robot description cache '" << path << "'.");
+    close(fd);
+    return false;
+  }
+
+  const std::size_t file_size = static_cast<std::size_t>(file_stat.st_size);
+  void* mapped = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED)
+  {
+    ROS_WARN_STREAM_NAMED("cache","Could not map robot description cache '" << path << "'.");
+    return false;
+  }
+  const char* begin = static_cast<const char*>(mapped);
+
+  // Header: magic, version, key and payload checksum
+  boost::uint32_t magic = 0, version = 0;
+  boost::uint64_t stored_key = 0, checksum = 0;
+  Decoder header(begin, begin + header_size);
+  header.read(magic);
+  header.read(version);
+  header.read(stored_key);
+  header.read(checksum);
+
+  bool ok = false;
+  if (magic != CACHE_MAGIC || version != CACHE_VERSION)
+  {
+    ROS_WARN_STREAM_NAMED("cache","Ignoring robot description cache '" << path << "' with unsupported format.");
+  }
+  else if (stored_key != key)
+  {
+    ROS_DEBUG_STREAM_NAMED("cache","Robot description cache '" << path << "' is stale.");
+  }
+  else if (checksum != fnv1a(begin + header_size, file_size - header_size))
+  {
+    ROS_WARN_STREAM_NAMED("cache","Ignoring corrupt robot description cache '" << path << "'.");
+  }
+  else
+  {
+    RobotDescriptionData tmp;
+    Decoder payload(begin + header_size, begin + file_size);
+    ok = decode(payload, tmp);
+    if (ok)
+    {
+      std::swap(data.transmissions_,     tmp.transmissions_);
+      std::swap(data.joint_limits_,      tmp.joint_limits_);
+      std::swap(data.soft_joint_limits_, tmp.soft_joint_limits_);
+    }
+    else
+    {
+      ROS_WARN_STREAM_NAMED("cache","Ignoring corrupt robot description cache '" << path << "'.");
+    }
+  }
+
+  munmap(mapped, file_size);
+  return ok;
+}
+
+bool RobotDescriptionCache::save(const std::string& path, boost::uint64_t key, const RobotDescriptionData& data)
+{
+  Encoder payload;
+  encode(data, payload);
+
+  Encoder header;
+  header.write(CACHE_MAGIC);
+  header.write(CACHE_VERSION);
+  header.write(key);
+  header.write(fnv1a(payload.buffer().data(), payload.buffer().size()));
+
+  std::ostringstream tmp_path;
+  tmp_path << path << ".tmp." << getpid();
+  {
+    std::ofstream file(tmp_path.str().c_str(), std::ios::binary | std::ios::trunc);
+    file.write(header.buffer().data(),  header.buffer().size());
+    file.write(payload.buffer().data(), payload.buffer().size());
+    file.close(); // Flushes, so that failing to write the tail of the file (eg. a full disk) is detected below
+    if (!file)
+    {
+      ROS_ERROR_STREAM_NAMED("cache","Could not write robot description cache '" << tmp_path.str() << "'.");
+      std::remove(tmp_path.str().c_str());
+      return false;
+    }
+  }
+
+  if (std::rename(tmp_path.str().c_str(), path.c_str()) != 0)
+  {
+    ROS_ERROR_STREAM_NAMED("cache","Could not write robot description cache '" << path << "'.");
+    std::remove(tmp_path.str().c_str());
+    return false;
+  }
+  return true;
+}
+
+} // namespace
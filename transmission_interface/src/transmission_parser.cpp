@@ -33,30 +33,81 @@
  *  POSSIBILITY OF SUCH DAMAGE.
  *********************************************************************/
 
+#include <utility>
+#include <vector>
+
 #include <transmission_interface/transmission_parser.h>
 
 namespace transmission_interface
 {
 
+const std::size_t XmlSubtree::npos;
+
+namespace
+{
+
+/// \return Position right after the first occurrence of \e token at or after \e pos, or \c npos if there is none.
+std::string::size_type skipPast(const std::string& str, std::string::size_type pos, const std::string& token)
+{
+  const std::string::size_type token_pos = str.find(token, pos);
+  return (token_pos == std::string::npos) ? std::string::npos : token_pos + token.size();
+}
+
+/// \return Position right after the closing '>' of the markup starting at \e pos, or \c npos if it is unterminated.
+/// Quoted attribute values and bracketed declaration subsets are skipped, as they may contain '>' characters.
+std::string::size_type skipTag(const std::string& str, std::string::size_type pos)
+{
+  char quote = '\0';
+  int  brackets = 0;
+  for (; pos < str.size(); ++pos)
+  {
+    const char c = str[pos];
+    if (quote != '\0')
+    {
+      if (c == quote) {quote = '\0';}
+    }
+    else if (c == '"' || c == '\'') {quote = c;}
+    else if (c == '[')              {++brackets;}
+    else if (c == ']')              {--brackets;}
+    else if (c == '>' && brackets <= 0) {return pos + 1;}
+  }
+  return std::string::npos;
+}
+
+/// \return Name of the element whose start tag begins at \e pos.
+std::string tagName(const std::string& str, std::string::size_type pos)
+{
+  const std::string::size_type name_begin = pos + 1;
+  const std::string::size_type name_end   = str.find_first_of(" \t\r\n/>", name_begin);
+  return str.substr(name_begin, name_end - name_begin);
+}
+
+} // namespace
+
 bool TransmissionParser::parse(const std::string& urdf, std::vector<TransmissionInfo>& transmissions)
 {
-  // initialize TiXmlDocument doc with a string
-  TiXmlDocument doc;
-  if (!doc.Parse(urdf.c_str()) && doc.Error())
+  // Locate the transmission elements without loading the whole robot description
+  std::vector<std::string> transmissions_xml;
+  if (!extractTransmissions(urdf, transmissions_xml))
   {
     ROS_ERROR("Could not load the gazebo_ros_control plugin's"
       " configuration file: %s\n", urdf.c_str());
     return false;
   }
 
-  // Find joints in transmission tags
-  TiXmlElement *root = doc.RootElement();
-
   // Constructs the transmissions by parsing custom xml.
-  TiXmlElement *trans_it = NULL;
-  for (trans_it = root->FirstChildElement("transmission"); trans_it;
-       trans_it = trans_it->NextSiblingElement("transmission"))
+  for (std::vector<std::string>::const_iterator xml_it = transmissions_xml.begin(); xml_it != transmissions_xml.end();
+       ++xml_it)
   {
+    // initialize TiXmlDocument doc with the transmission element only
+    TiXmlDocument doc;
+    if (!doc.Parse(xml_it->c_str()) && doc.Error())
+    {
+      ROS_ERROR_STREAM_NAMED("parser","Could not parse transmission element: " << doc.ErrorDesc());
+      return false;
+    }
+    TiXmlElement *trans_it = doc.RootElement();
+
     transmission_interface::TransmissionInfo transmission;
 
     // Transmission name
@@ -115,6 +166,87 @@ bool TransmissionParser::parse(const std::string& urdf, std::vector<Transmission
   return true;
 }
 
+bool TransmissionParser::extractTransmissions(const std::string& urdf, std::vector<std::string>& transmissions_xml)
+{
+  const std::string::size_type npos = std::string::npos;
+
+  int depth = 0;                         // Nesting level of elements, the root element children are at level one
+  bool root_found = false;
+  std::string::size_type trans_begin = npos; // Start of the transmission element being scanned, if any
+
+  std::string::size_type pos = 0;
+  while ((pos = urdf.find('<', pos)) != npos)
+  {
+    // Find the end of the current markup. Comments, CDATA sections, processing instructions and declarations don't
+    // affect element nesting, so they are skipped altogether
+    std::string::size_type end;
+    bool start_tag = false;
+    bool end_tag   = false;
+    if      (urdf.compare(pos, 4, "<!--") == 0)      {end = skipPast(urdf, pos, "-->");}
+    else if (urdf.compare(pos, 9, "<![CDATA[") == 0) {end = skipPast(urdf, pos, "]]>");}
+    else if (urdf.compare(pos, 2, "<?") == 0)        {end = skipPast(urdf, pos, "?>");}
+    else if (urdf.compare(pos, 2, "<!") == 0)        {end = skipTag(urdf, pos);}
+    else if (urdf.compare(pos, 2, "</") == 0)        {end = skipTag(urdf, pos); end_tag = true;}
+    else                                             {end = skipTag(urdf, pos); start_tag = true;}
+
+    if (end == npos)
+    {
+      ROS_ERROR_STREAM_NAMED("parser","Unterminated markup at offset " << pos);
+      return false;
+    }
+
+    if (start_tag)
+    {
+      root_found = true;
+      const bool empty_element = urdf[end - 2] == '/';
+
+      // Only the direct children of the root element are considered
+      if (depth == 1 && tagName(urdf, pos) == "transmission")
+      {
+        trans_begin = pos;
+      }
+      if (!empty_element)
+      {
+        ++depth;
+      }
+    }
+    else if (end_tag)
+    {
+      --depth;
+      if (depth < 0)
+      {
+        ROS_ERROR_STREAM_NAMED("parser","Unbalanced end tag at offset " << pos);
+        return false;
+      }
+    }
+
+    // Transmission element is complete once we're back at the level of the root element children
+    if (trans_begin != npos && depth == 1)
+    {
+      transmissions_xml.push_back(urdf.substr(trans_begin, end - trans_begin));
+      trans_begin = npos;
+    }
+
+    // Anything past the root element is ignored
+    if (root_found && depth == 0)
+    {
+      return true;
+    }
+
+    pos = end;
+  }
+
+  if (!root_found)
+  {
+    ROS_ERROR_STREAM_NAMED("parser","No root element found");
+  }
+  else
+  {
+    ROS_ERROR_STREAM_NAMED("parser","Root element is not terminated");
+  }
+  return false;
+}
+
 bool TransmissionParser::parseJoints(TiXmlElement *trans_it, std::vector<JointInfo>& joints)
 {
   // Loop through each available joint
@@ -125,8 +257,8 @@ bool TransmissionParser::parseJoints(TiXmlElement *trans_it, std::vector<JointIn
     // Create new joint
     transmission_interface::JointInfo joint;
 
-    // Joint xml element
-    joint.xml_element_ = joint_it;
+    // Joint xml element, copied as it won't outlive this call
+    copyElement(joint_it, joint.xml_element_);
 
     // Joint name
     if(joint_it->Attribute("name"))
@@ -164,8 +296,8 @@ bool TransmissionParser::parseActuators(TiXmlElement *trans_it, std::vector<Actu
     // Create new actuator
     transmission_interface::ActuatorInfo actuator;
 
-    // Actuator xml element
-    actuator.xml_element_ = actuator_it;
+    // Actuator xml element, copied as it won't outlive this call
+    copyElement(actuator_it, actuator.xml_element_);
 
     // Actuator name
     if(actuator_it->Attribute("name"))
@@ -209,4 +341,42 @@ bool TransmissionParser::parseActuators(TiXmlElement *trans_it, std::vector<Actu
   return true;
 }
 
+void TransmissionParser::copyElement(const TiXmlElement *element, XmlSubtree& subtree)
+{
+  subtree.elements_.clear();
+
+  // Depth-first traversal, elements get stored in document order
+  std::vector<std::pair<const TiXmlElement*, std::size_t> > pending; // Element and index of its parent
+  pending.push_back(std::make_pair(element, XmlSubtree::npos));
+  while (!pending.empty())
+  {
+    const TiXmlElement *current = pending.back().first;
+    const std::size_t parent    = pending.back().second;
+    pending.pop_back();
+
+    XmlSubtree::Element data;
+    data.name_   = current->Value();
+    data.text_   = current->GetText() ? current->GetText() : "";
+    data.parent_ = parent;
+    for (const TiXmlAttribute *attr_it = current->FirstAttribute(); attr_it; attr_it = attr_it->Next())
+    {
+      data.attributes_[attr_it->Name()] = attr_it->Value();
+    }
+    subtree.elements_.push_back(data);
+
+    // Children are pushed in reverse so that the first one is visited next
+    std::vector<const TiXmlElement*> children;
+    for (const TiXmlElement *child_it = current->FirstChildElement(); child_it;
+         child_it = child_it->NextSiblingElement())
+    {
+      children.push_back(child_it);
+    }
+    for (std::vector<const TiXmlElement*>::reverse_iterator child_it = children.rbegin(); child_it != children.rend();
+         ++child_it)
+    {
+      pending.push_back(std::make_pair(*child_it, subtree.elements_.size() - 1));
+    }
+  }
+}
+
 } // namespace
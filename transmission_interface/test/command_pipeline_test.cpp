@@ -0,0 +1,185 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013, PAL Robotics S.L.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of hiDOF, Inc. nor the names of its
+//     contributors may be used to endorse or promote products derived from
+//     this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//////////////////////////////////////////////////////////////////////////////
+
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <hardware_interface/joint_command_interface.h>
+#include <joint_limits_interface/joint_limits_interface.h>
+#include <transmission_interface/command_pipeline.h>
+#include <transmission_interface/differential_transmission.h>
+#include <transmission_interface/simple_transmission.h>
+
+using std::vector;
+using std::string;
+using namespace hardware_interface;
+using namespace joint_limits_interface;
+using namespace transmission_interface;
+
+// Floating-point value comparison threshold
+const double EPS = 1e-6;
+
+/**
+ * Robot with three velocity-controlled joints: one driven by a simple transmission, and two driven by a differential
+ * transmission. Only joints 1 and 3 have limits.
+ */
+class CommandPipelineTest : public ::testing::Test
+{
+public:
+  CommandPipelineTest()
+    : simple_trans(10.0),
+      diff_trans(vector<double>(2, 10.0), vector<double>(2, 1.0)),
+      jnt_pos(3, 0.0), jnt_vel(3, 0.0), jnt_eff(3, 0.0), jnt_cmd(3, 0.0),
+      act_cmd(3, 0.0)
+  {
+    JointLimits limits;
+    limits.has_velocity_limits = true;
+    limits.max_velocity = 1.0;
+
+    const string names[] = {"joint1", "joint2", "joint3"};
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      joint_names.push_back(names[i]);
+      JointHandle jh(JointStateHandle(names[i], &jnt_pos[i], &jnt_vel[i], &jnt_eff[i]), &jnt_cmd[i]);
+      if (i != 1) {limits_iface.registerHandle(VelocityJointSaturationHandle(jh, limits));}
+    }
+
+    // Simple transmission
+    {
+      ActuatorData a_data;
+      JointData j_data;
+      a_data.velocity.push_back(&act_cmd[0]);
+      j_data.velocity.push_back(&jnt_cmd[0]);
+      trans_iface.registerHandle(JointToActuatorVelocityHandle("simple", &simple_trans, a_data, j_data));
+    }
+
+    // Differential transmission
+    {
+      ActuatorData a_data;
+      JointData j_data;
+      a_data.velocity.push_back(&act_cmd[1]);
+      a_data.velocity.push_back(&act_cmd[2]);
+      j_data.velocity.push_back(&jnt_cmd[1]);
+      j_data.velocity.push_back(&jnt_cmd[2]);
+      trans_iface.registerHandle(JointToActuatorVelocityHandle("differential", &diff_trans, a_data, j_data));
+    }
+  }
+
+protected:
+  SimpleTransmission simple_trans;
+  DifferentialTransmission diff_trans;
+  vector<double> jnt_pos, jnt_vel, jnt_eff, jnt_cmd;
+  vector<double> act_cmd;
+  vector<string> joint_names;
+  VelocityJointSaturationInterface limits_iface;
+  JointToActuatorVelocityInterface trans_iface;
+};
+
+TEST_F(CommandPipelineTest, UnknownTransmission)
+{
+  CommandPipeline<VelocityJointSaturationHandle, JointToActuatorVelocityHandle> pipeline;
+  EXPECT_THROW(pipeline.addGroup(limits_iface, trans_iface, "unknown", joint_names), TransmissionInterfaceException);
+  EXPECT_EQ(0, pipeline.size());
+}
+
+TEST_F(CommandPipelineTest, SameResultAsSeparatePasses)
+{
+  CommandPipeline<VelocityJointSaturationHandle, JointToActuatorVelocityHandle> pipeline;
+  pipeline.addGroup(limits_iface, trans_iface, "simple",       vector<string>(1, "joint1"));
+  pipeline.addGroup(limits_iface, trans_iface, "differential", vector<string>(joint_names.begin() + 1,
+                                                                              joint_names.end()));
+  ASSERT_EQ(2, pipeline.size());
+
+  const ros::Duration period(0.01);
+  const double cmds[] = {-2.0, -0.5, 0.0, 0.7, 3.0};
+  const unsigned int n_cmds = sizeof(cmds) / sizeof(cmds[0]);
+  for (unsigned int i = 0; i < n_cmds; ++i)
+  {
+    // Separate passes
+    jnt_cmd[0] = cmds[i];
+    jnt_cmd[1] = cmds[(i + 1) % n_cmds];
+    jnt_cmd[2] = cmds[(i + 2) % n_cmds];
+    limits_iface.enforceLimits(period);
+    trans_iface.propagate();
+    const vector<double> expected_jnt_cmd = jnt_cmd;
+    const vector<double> expected_act_cmd = act_cmd;
+
+    // Fused pass
+    jnt_cmd[0] = cmds[i];
+    jnt_cmd[1] = cmds[(i + 1) % n_cmds];
+    jnt_cmd[2] = cmds[(i + 2) % n_cmds];
+    act_cmd.assign(3, 0.0);
+    pipeline.update(period);
+
+    for (unsigned int j = 0; j < 3; ++j)
+    {
+      EXPECT_NEAR(expected_jnt_cmd[j], jnt_cmd[j], EPS);
+      EXPECT_NEAR(expected_act_cmd[j], act_cmd[j], EPS);
+    }
+  }
+
+  // Joint without limits is propagated as-is
+  jnt_cmd[0] = 0.0;
+  jnt_cmd[1] = 5.0;
+  jnt_cmd[2] = 0.0;
+  pipeline.update(period);
+  EXPECT_NEAR(5.0, jnt_cmd[1], EPS);
+
+  pipeline.clear();
+  EXPECT_EQ(0, pipeline.size());
+}
+
+TEST_F(CommandPipelineTest, ConfigureFromTransmissionInfo)
+{
+  vector<TransmissionInfo> infos(3);
+  infos[0].name_ = "simple";
+  infos[0].joints_.resize(1);
+  infos[0].joints_[0].name_ = "joint1";
+  infos[1].name_ = "differential";
+  infos[1].joints_.resize(2);
+  infos[1].joints_[0].name_ = "joint2";
+  infos[1].joints_[1].name_ = "joint3";
+  infos[2].name_ = "not_in_interface";
+
+  CommandPipeline<VelocityJointSaturationHandle, JointToActuatorVelocityHandle> pipeline;
+  pipeline.configure(limits_iface, trans_iface, infos);
+  ASSERT_EQ(2, pipeline.size());
+
+  jnt_cmd[0] = 2.0;
+  pipeline.update(ros::Duration(0.01));
+  EXPECT_NEAR(1.0,  jnt_cmd[0], EPS);
+  EXPECT_NEAR(10.0, act_cmd[0], EPS);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,171 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Open Source Robotics Foundation
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Open Source Robotics Foundation
+ *     nor the names of its contributors may be
+ *     used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <transmission_interface/robot_description_cache.h>
+
+using std::string;
+using namespace transmission_interface;
+
+class RobotDescriptionCacheTest : public ::testing::Test
+{
+public:
+  RobotDescriptionCacheTest()
+    : path("/tmp/robot_description_cache_test_" + toString(getpid())),
+      key(RobotDescriptionCache::computeKey("<robot name=\"robot\"/>", "limits"))
+  {
+    XmlSubtree::Element actuator_xml;
+    actuator_xml.name_ = "actuator";
+    actuator_xml.attributes_["name"] = "actuator_1";
+    actuator_xml.parent_ = XmlSubtree::npos;
+
+    XmlSubtree::Element reduction_xml;
+    reduction_xml.name_ = "mechanicalReduction";
+    reduction_xml.text_ = "50";
+    reduction_xml.parent_ = 0;
+
+    ActuatorInfo actuator;
+    actuator.name_ = "actuator_1";
+    actuator.hardware_interface_ = "EffortJointInterface";
+    actuator.xml_element_.elements_.push_back(actuator_xml);
+    actuator.xml_element_.elements_.push_back(reduction_xml);
+
+    JointInfo joint;
+    joint.name_ = "joint_1";
+
+    TransmissionInfo transmission;
+    transmission.name_ = "trans_1";
+    transmission.type_ = "transmission_interface/SimpleTransmission";
+    transmission.joints_.push_back(joint);
+    transmission.actuators_.push_back(actuator);
+    data.transmissions_.push_back(transmission);
+
+    data.joint_limits_["joint_1"].has_velocity_limits = true;
+    data.joint_limits_["joint_1"].max_velocity = 2.0;
+    data.soft_joint_limits_["joint_1"].k_position = 10.0;
+  }
+
+  ~RobotDescriptionCacheTest() {std::remove(path.c_str());}
+
+protected:
+  string path;
+  boost::uint64_t key;
+  RobotDescriptionData data;
+
+  static string toString(int val)
+  {
+    std::ostringstream os;
+    os << val;
+    return os.str();
+  }
+};
+
+TEST_F(RobotDescriptionCacheTest, ComputeKey)
+{
+  EXPECT_EQ(key, RobotDescriptionCache::computeKey("<robot name=\"robot\"/>", "limits"));
+  EXPECT_NE(key, RobotDescriptionCache::computeKey("<robot name=\"robot2\"/>", "limits"));
+  EXPECT_NE(key, RobotDescriptionCache::computeKey("<robot name=\"robot\"/>", "limits2"));
+  EXPECT_NE(RobotDescriptionCache::computeKey("ab", "c"), RobotDescriptionCache::computeKey("a", "bc"));
+
+  // The key does not depend on the byte order of the host
+  EXPECT_EQ(0xe3a9285f01a990e1ULL, key);
+}
+
+TEST_F(RobotDescriptionCacheTest, SaveAndLoad)
+{
+  RobotDescriptionData loaded;
+  EXPECT_FALSE(RobotDescriptionCache::load(path, key, loaded)); // No cache yet
+
+  ASSERT_TRUE(RobotDescriptionCache::save(path, key, data));
+  ASSERT_TRUE(RobotDescriptionCache::load(path, key, loaded));
+
+  ASSERT_EQ(1, loaded.transmissions_.size());
+  const TransmissionInfo& transmission = loaded.transmissions_.front();
+  EXPECT_EQ("trans_1", transmission.name_);
+  EXPECT_EQ("transmission_interface/SimpleTransmission", transmission.type_);
+  ASSERT_EQ(1, transmission.joints_.size());
+  EXPECT_EQ("joint_1", transmission.joints_.front().name_);
+  ASSERT_EQ(1, transmission.actuators_.size());
+  EXPECT_EQ("EffortJointInterface", transmission.actuators_.front().hardware_interface_);
+
+  string value;
+  EXPECT_TRUE(transmission.actuators_.front().xml_element_.getChildText("mechanicalReduction", value));
+  EXPECT_EQ("50", value);
+  EXPECT_TRUE(transmission.actuators_.front().xml_element_.getAttribute("name", value));
+  EXPECT_EQ("actuator_1", value);
+
+  ASSERT_EQ(1, loaded.joint_limits_.count("joint_1"));
+  EXPECT_TRUE(loaded.joint_limits_["joint_1"].has_velocity_limits);
+  EXPECT_FALSE(loaded.joint_limits_["joint_1"].has_position_limits);
+  EXPECT_EQ(2.0, loaded.joint_limits_["joint_1"].max_velocity);
+  ASSERT_EQ(1, loaded.soft_joint_limits_.count("joint_1"));
+  EXPECT_EQ(10.0, loaded.soft_joint_limits_["joint_1"].k_position);
+}
+
+TEST_F(RobotDescriptionCacheTest, StaleOrCorruptCache)
+{
+  ASSERT_TRUE(RobotDescriptionCache::save(path, key, data));
+
+  // Key mismatch
+  RobotDescriptionData loaded;
+  EXPECT_FALSE(RobotDescriptionCache::load(path, key + 1, loaded));
+  EXPECT_TRUE(loaded.transmissions_.empty());
+
+  // Truncated file
+  {
+    std::ifstream in(path.c_str(), std::ios::binary);
+    const string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+    out.write(contents.data(), contents.size() / 2);
+  }
+  EXPECT_FALSE(RobotDescriptionCache::load(path, key, loaded));
+  EXPECT_TRUE(loaded.transmissions_.empty());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,137 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2013, Open Source Robotics Foundation
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Open Source Robotics Foundation
+ *     nor the names of its contributors may be
+ *     used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <transmission_interface/transmission_parser.h>
+
+using std::string;
+using std::vector;
+using namespace transmission_interface;
+
+const string TRANSMISSION_XML =
+  "  <transmission name=\"trans_1\">\n"
+  "    <type>transmission_interface/SimpleTransmission</type>\n"
+  "    <joint name=\"joint_1\"/>\n"
+  "    <actuator name=\"actuator_1\">\n"
+  "      <hardwareInterface>EffortJointInterface</hardwareInterface>\n"
+  "      <mechanicalReduction>50</mechanicalReduction>\n"
+  "    </actuator>\n"
+  "  </transmission>\n";
+
+TEST(TransmissionParserTest, ParseTransmissions)
+{
+  const string urdf =
+    "<?xml version=\"1.0\"?>\n"
+    "<!-- <transmission name=\"commented_out\"/> -->\n"
+    "<robot name=\"robot\">\n"
+    "  <link name=\"link_1\">\n"
+    "    <visual><geometry><mesh filename=\"package://robot/meshes/link_1.dae\"/></geometry></visual>\n"
+    "    <transmission name=\"nested\"/>\n" // Not a child of the root element
+    "  </link>\n"
+    "  <joint name=\"joint_1\" type=\"revolute\"><parent link=\"a>b\"/></joint>\n"
+    + TRANSMISSION_XML +
+    "  <gazebo><![CDATA[ <transmission> ]]></gazebo>\n"
+    "  <!-- </robot> -->\n"
+    + TRANSMISSION_XML +
+    "</robot>\n";
+
+  vector<TransmissionInfo> transmissions;
+  ASSERT_TRUE(TransmissionParser::parse(urdf, transmissions));
+  ASSERT_EQ(2, transmissions.size());
+
+  const TransmissionInfo& info = transmissions.front();
+  EXPECT_EQ("trans_1", info.name_);
+  EXPECT_EQ("transmission_interface/SimpleTransmission", info.type_);
+  ASSERT_EQ(1, info.joints_.size());
+  EXPECT_EQ("joint_1", info.joints_.front().name_);
+  ASSERT_EQ(1, info.actuators_.size());
+  EXPECT_EQ("actuator_1", info.actuators_.front().name_);
+  EXPECT_EQ("EffortJointInterface", info.actuators_.front().hardware_interface_);
+}
+
+TEST(TransmissionParserTest, ElementData)
+{
+  vector<TransmissionInfo> transmissions;
+  ASSERT_TRUE(TransmissionParser::parse("<robot name=\"robot\">" + TRANSMISSION_XML + "</robot>", transmissions));
+  ASSERT_EQ(1, transmissions.size());
+
+  // Element data outlives the parsed document
+  const XmlSubtree& joint_xml = transmissions.front().joints_.front().xml_element_;
+  ASSERT_EQ(1, joint_xml.elements_.size());
+  EXPECT_EQ("joint", joint_xml.elements_.front().name_);
+
+  string value;
+  EXPECT_TRUE(joint_xml.getAttribute("name", value));
+  EXPECT_EQ("joint_1", value);
+  EXPECT_FALSE(joint_xml.getAttribute("type", value));
+  EXPECT_FALSE(joint_xml.getChildText("offset", value));
+
+  const XmlSubtree& actuator_xml = transmissions.front().actuators_.front().xml_element_;
+  ASSERT_EQ(3, actuator_xml.elements_.size());
+  EXPECT_TRUE(actuator_xml.getChildText("mechanicalReduction", value));
+  EXPECT_EQ("50", value);
+  EXPECT_TRUE(actuator_xml.getChildText("hardwareInterface", value));
+  EXPECT_EQ("EffortJointInterface", value);
+  EXPECT_EQ(XmlSubtree::npos, actuator_xml.findChild("mechanicalReduction", 1));
+}
+
+TEST(TransmissionParserTest, NoTransmissions)
+{
+  vector<TransmissionInfo> transmissions;
+  EXPECT_TRUE(TransmissionParser::parse("<robot name=\"robot\"><link name=\"link_1\"/></robot>", transmissions));
+  EXPECT_TRUE(transmissions.empty());
+}
+
+TEST(TransmissionParserTest, MalformedDescription)
+{
+  vector<TransmissionInfo> transmissions;
+  EXPECT_FALSE(TransmissionParser::parse("", transmissions));
+  EXPECT_FALSE(TransmissionParser::parse("<robot name=\"robot\">" + TRANSMISSION_XML, transmissions));
+  EXPECT_FALSE(TransmissionParser::parse("<robot name=\"robot\"><link name=\"link_1\"></robot>", transmissions));
+  EXPECT_FALSE(TransmissionParser::parse("<robot name=\"robot\"><!-- </robot>", transmissions));
+  EXPECT_FALSE(TransmissionParser::parse("<robot name=\"robot\"><transmission name=\"trans_1\"><type></robot>",
+                                         transmissions));
+  EXPECT_TRUE(transmissions.empty());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}